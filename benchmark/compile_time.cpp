@@ -0,0 +1,60 @@
+//
+// Compile time benchmark.
+//
+// Instantiates every algorithm family with every table size and computes the
+// check value at compile time. There is nothing to run, the cost is the build
+// of this file. Configure with ENABLE_COMPILE_TIME_BENCHMARK to add it; on
+// clang it is always built with -ftime-trace, producing a report for it.
+//
+#include "crc_cpp.h"
+
+using namespace crc_cpp;
+
+namespace
+{
+
+template<typename TCrc> constexpr typename TCrc::accumulator_type check_value()
+{
+    constexpr std::array<uint8_t, 9> message{'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+    TCrc crc;
+    crc.update(message.data(), message.size());
+    return crc.final();
+}
+
+// all table sizes must produce the same result
+template<template<const table_size> class TFamily> constexpr bool check_family()
+{
+    constexpr auto tiny = check_value<TFamily<table_size::tiny>>();
+    constexpr auto small = check_value<TFamily<table_size::small>>();
+    constexpr auto large = check_value<TFamily<table_size::large>>();
+
+    return tiny == small && small == large;
+}
+
+template<template<const table_size> class ...TFamilies> constexpr bool check_families()
+{
+    return (check_family<TFamilies>() && ...);
+}
+
+static_assert(check_families<
+                  family::crc8, family::crc8_cdma2000, family::crc8_darc, family::crc8_dvbs2, family::crc8_ebu,
+                  family::crc8_icode, family::crc8_itu, family::crc8_maxim, family::crc8_rohc, family::crc8_wcdma>(),
+              "8 bit table sizes disagree");
+
+static_assert(check_families<
+                  family::crc16_ccit, family::crc16_arc, family::crc16_augccit, family::crc16_buypass, family::crc16_cdma2000,
+                  family::crc16_dds110, family::crc16_dectr, family::crc16_dectx, family::crc16_dnp, family::crc16_en13757,
+                  family::crc16_genibus, family::crc16_maxim, family::crc16_mcrf4xx, family::crc16_riello, family::crc16_t10dif,
+                  family::crc16_teledisk, family::crc16_tms37157, family::crc16_usb, family::crc16_a, family::crc16_kermit,
+                  family::crc16_modbus, family::crc16_x25, family::crc16_xmodem, family::crc16_m17lsf>(),
+              "16 bit table sizes disagree");
+
+static_assert(check_families<
+                  family::crc32, family::crc32_bzip2, family::crc32_c, family::crc32_d, family::crc32_mpeg2,
+                  family::crc32_posix, family::crc32_q, family::crc32_jamcrc, family::crc32_xfer>(),
+              "32 bit table sizes disagree");
+
+static_assert(check_families<family::crc64_ecma>(), "64 bit table sizes disagree");
+
+}   // namespace
@@ -0,0 +1,113 @@
+#
+# Embed a binary file in a target along with CRCs of it computed at compile time.
+#
+#   CRC_CPP_EMBED_RESOURCE(<target> <name> <file>
+#                          [NAMESPACE <namespace>]
+#                          [CRCS <crc>...])
+#
+# Generates <name>.h in the build tree, added to the include path of <target>, which defines
+#
+#   inline constexpr uint8_t <namespace>::<name>[];            // the file contents
+#   inline constexpr auto <namespace>::<name>_<crc> = ...;     // for each crc_cpp::<crc> listed
+#
+# eg CRCS crc32 large::crc16_ccit gives <name>_crc32 and <name>_crc16_ccit. The namespace defaults to
+# "resources". The data uses #embed where the compiler supports it, otherwise a generated array,
+# and the header is regenerated when the file changes.
+#
+# The CRCs use crc_cpp::compute_constant(), and the constexpr evaluation limits of <target> are
+# raised to suit the size of the file.
+#
+
+INCLUDE(CheckCXXSourceCompiles)
+
+# Write the header, usable in script mode as well
+FUNCTION(CRC_CPP_WRITE_EMBED_HEADER header name file namespace use_embed)
+    SET(crcs ${ARGN})
+    GET_FILENAME_COMPONENT(file "${file}" ABSOLUTE)
+
+    FILE(SIZE "${file}" size)
+    IF(size EQUAL 0)
+        MESSAGE(FATAL_ERROR "Cannot embed empty file ${file}")
+    ENDIF()
+
+    STRING(MAKE_C_IDENTIFIER "CRC_CPP_EMBED_${namespace}_${name}_H_INCLUDED" guard)
+    STRING(TOUPPER "${guard}" guard)
+
+    IF(use_embed)
+        SET(data "#embed \"${file}\"")
+    ELSE()
+        FILE(READ "${file}" data HEX)
+        STRING(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," data "${data}")
+        STRING(REPEAT "0x..," 16 line)
+        STRING(REGEX REPLACE "(${line})" "\\1\n        " data "${data}")
+        STRING(STRIP "${data}" data)
+        SET(data "        ${data}")
+    ENDIF()
+
+    SET(content "// Generated by CRC_CPP_EMBED_RESOURCE from ${file}, do not edit\n")
+    STRING(APPEND content "#ifndef ${guard}\n#define ${guard}\n\n#include \"crc_cpp_embed.h\"\n\n")
+    STRING(APPEND content "namespace ${namespace}\n{\n")
+    STRING(APPEND content "    inline constexpr uint8_t ${name}[] = {\n${data}\n    };\n")
+    FOREACH(crc IN LISTS crcs)
+        STRING(REGEX REPLACE ".*::" "" crc_name "${crc}")
+        STRING(MAKE_C_IDENTIFIER "${name}_${crc_name}" constant)
+        STRING(APPEND content "    inline constexpr auto ${constant} = crc_cpp::compute_constant<crc_cpp::${crc}>(${name});\n")
+    ENDFOREACH()
+    STRING(APPEND content "}   // namespace ${namespace}\n\n#endif // ${guard}\n")
+
+    # only touch the header when it changes, so dependants are not rebuilt needlessly
+    FILE(WRITE "${header}.tmp" "${content}")
+    EXECUTE_PROCESS(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${header}.tmp" "${header}")
+    FILE(REMOVE "${header}.tmp")
+ENDFUNCTION()
+
+FUNCTION(CRC_CPP_EMBED_RESOURCE target name file)
+    CMAKE_PARSE_ARGUMENTS(EMBED "" "NAMESPACE" "CRCS" ${ARGN})
+    IF(NOT EMBED_NAMESPACE)
+        SET(EMBED_NAMESPACE "resources")
+    ENDIF()
+
+    GET_FILENAME_COMPONENT(file "${file}" ABSOLUTE)
+
+    IF(NOT DEFINED CRC_CPP_HAS_EMBED)
+        # #embed is an extension before C++26, only use it where it is clean under -Wpedantic
+        IF(CMAKE_CXX_COMPILER_ID STREQUAL "GNU" OR CMAKE_CXX_COMPILER_ID MATCHES ".*Clang")
+            SET(CMAKE_REQUIRED_FLAGS "-Wpedantic -Werror")
+        ENDIF()
+        CHECK_CXX_SOURCE_COMPILES("
+            constexpr unsigned char data[] = {
+            #embed __FILE__
+            };
+            int main() { return data[0] == 0; }" CRC_CPP_HAS_EMBED)
+    ENDIF()
+
+    SET(directory "${CMAKE_CURRENT_BINARY_DIR}/crc_cpp_embed")
+    CRC_CPP_WRITE_EMBED_HEADER("${directory}/${name}.h" "${name}" "${file}" "${EMBED_NAMESPACE}" "${CRC_CPP_HAS_EMBED}" ${EMBED_CRCS})
+
+    # regenerate when the resource changes
+    SET_PROPERTY(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${file}")
+    TARGET_INCLUDE_DIRECTORIES(${target} PRIVATE "${directory}")
+
+    # Each CRC constant is a separate evaluation. With g++ 12 compute_constant() measures 19 to 22
+    # operations per byte for 8 to 64 bit CRCs, so allow 32 per byte plus a fixed allowance for the
+    # tail. Clang and MSVC count coarser steps, so this also covers them. Keep the largest budget of
+    # any resource in the target as the last limit given on the command line wins.
+    FILE(SIZE "${file}" size)
+    MATH(EXPR budget "${size} * 32 + 4194304")
+    GET_TARGET_PROPERTY(current ${target} CRC_CPP_CONSTEXPR_BUDGET)
+    IF(current AND current GREATER_EQUAL budget)
+        RETURN()
+    ENDIF()
+    SET_TARGET_PROPERTIES(${target} PROPERTIES CRC_CPP_CONSTEXPR_BUDGET ${budget})
+
+    IF(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        # the default is 2^25
+        IF(budget GREATER 33554432)
+            TARGET_COMPILE_OPTIONS(${target} PRIVATE -fconstexpr-ops-limit=${budget})
+        ENDIF()
+    ELSEIF(CMAKE_CXX_COMPILER_ID MATCHES ".*Clang")
+        TARGET_COMPILE_OPTIONS(${target} PRIVATE -fconstexpr-steps=${budget})
+    ELSEIF(MSVC)
+        TARGET_COMPILE_OPTIONS(${target} PRIVATE /constexpr:steps${budget})
+    ENDIF()
+ENDFUNCTION()
@@ -26,7 +26,11 @@
  */
 
 #include <cstdint>
+#include <cstddef>
 #include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 
 //
@@ -93,8 +97,54 @@ namespace util
         return value;
     }
 
+    //
+    // Detect compile time evaluation so runtime-only code (instrumentation) can be skipped.
+    // Under C++17 we rely on the compiler builtin where it exists.
+    //
+    [[nodiscard]] constexpr bool is_constant_evaluated()
+    {
+#ifdef CRC_CPP_STD20_MODE
+        return std::is_constant_evaluated();
+#elif defined(__GNUC__) || defined(_MSC_VER)
+        return __builtin_is_constant_evaluated();
+#else
+        return false;
+#endif
+    }
+
 }   // namespace util
 
+namespace instrument
+{
+    //
+    // The update path that serviced a call, reported to instrumentation policies.
+    //
+    enum class engine
+    {
+        per_byte,   // update(uint8_t) - one byte per call
+        bulk,       // update(data, length)
+        zeros,      // update_zeros(length)
+        count       // number of engines, not an engine
+    };
+
+    //
+    // Default instrumentation policy for impl::crc. Records nothing and compiles away entirely.
+    //
+    // A policy that wants to record must provide:
+    //
+    //   static constexpr bool enabled = true;
+    //   template<typename TAlgorithm, table_size TABLE_SIZE, typename TWork>
+    //   static void record(std::size_t bytes, engine e, TWork &&work);
+    //
+    // where record() must invoke work() exactly once. See crc_cpp_telemetry.h
+    //
+    struct disabled
+    {
+        static constexpr bool enabled = false;
+    };
+
+}   // namespace instrument
+
 
 namespace impl
 {
@@ -219,6 +269,28 @@ namespace impl
         {
             return init;
         }
+
+        //
+        // GF(2) polynomial helpers, used to shift a register over runs of zeros.
+        // The register holds the x^(ACCUMULATOR_BITS-1) coefficient in the MSB.
+        //
+        [[nodiscard]] static constexpr TAccumulator unity()
+        {
+            return TAccumulator(1u);
+        }
+
+        [[nodiscard]] static constexpr bool has_term(TAccumulator value, std::size_t degree)
+        {
+            return (value >> degree) & 0x1u;
+        }
+
+        [[nodiscard]] static constexpr TAccumulator multiply_x(TAccumulator value, TAccumulator const polynomial)
+        {
+            if(value & (TAccumulator(1u) << (traits::ACCUMULATOR_BITS - 1))) {
+                return static_cast<TAccumulator>((value << 1) ^ polynomial);
+            }
+            return static_cast<TAccumulator>(value << 1);
+        }
     };
 
     template <typename TAccumulator, const table_size TABLE_SIZE>
@@ -297,6 +369,28 @@ namespace impl
         {
             return util::reverse_bits(init);
         }
+
+        //
+        // GF(2) polynomial helpers, used to shift a register over runs of zeros.
+        // The register is reflected, holding the x^0 coefficient in the MSB.
+        //
+        [[nodiscard]] static constexpr TAccumulator unity()
+        {
+            return static_cast<TAccumulator>(TAccumulator(1u) << (traits::ACCUMULATOR_BITS - 1));
+        }
+
+        [[nodiscard]] static constexpr bool has_term(TAccumulator value, std::size_t degree)
+        {
+            return (value >> (traits::ACCUMULATOR_BITS - 1 - degree)) & 0x1u;
+        }
+
+        [[nodiscard]] static constexpr TAccumulator multiply_x(TAccumulator value, TAccumulator const polynomial)
+        {
+            if(value & 0x1u) {
+                return static_cast<TAccumulator>((value >> 1) ^ util::reverse_bits(polynomial));
+            }
+            return static_cast<TAccumulator>(value >> 1);
+        }
     };
 
 
@@ -344,7 +438,7 @@ namespace impl
     private:
 
 // If we are C++20 or above, we can leverage cleaner constexpr initialisation
-// otherwise we will attempt to use a static table builder metaprogramming pattern
+// otherwise we expand the table from a std::index_sequence
 // NOTE: Only C++17 will work, other constexpr code prevents C++14 and below working.
 #ifdef CRC_CPP_STD20_MODE
         [[nodiscard]] static constexpr typename traits::table_type Generate()
@@ -363,21 +457,154 @@ namespace impl
 #else
         // table builder for C++17
 
-        // recursive case
-        template<uint16_t INDEX = 0, TAccumulator ...D>
-        struct table_builder : table_builder<INDEX+1, D..., policy::generate_entry(POLYNOMIAL, INDEX)> {};
-
-        // termination of recursion at table length
-        template<TAccumulator ...D>
-        struct table_builder<traits::TABLE_ENTRIES, D...>
+        // expand every entry in a single pack expansion, so there is no
+        // per-entry template instantiation or recursion depth
+        template<std::size_t ...INDEX>
+        [[nodiscard]] static constexpr typename traits::table_type Generate(std::index_sequence<INDEX...>)
         {
-            static constexpr typename traits::table_type table = {D...};
-        };
+            return {{ policy::generate_entry(POLYNOMIAL, static_cast<uint8_t>(INDEX))... }};
+        }
 
-        static constexpr typename traits::table_type m_Table = table_builder<>::table;
+        static constexpr typename traits::table_type m_Table = Generate(std::make_index_sequence<traits::TABLE_ENTRIES>{});
 #endif
     };
 
+    //
+    // Advance a CRC register over a run of zero bytes in O(log n).
+    //
+    // Feeding n zero bytes multiplies the register by x^(8n) mod P. We precompute
+    // x^(8 * 2^k) mod P for every k and multiply in the powers for the set bits of n.
+    //
+    template <typename TAccumulator,
+              TAccumulator const POLYNOMIAL,
+              bool const REVERSE>
+    class crc_shift
+    {
+    public:
+        using policy = typename crc_chunk_table<TAccumulator, POLYNOMIAL, REVERSE, table_size::small>::policy;
+        using traits = typename policy::traits;
+
+        // the register after feeding it length zero bytes
+        [[nodiscard]] static constexpr TAccumulator shift(TAccumulator crc, std::size_t length)
+        {
+            for(std::size_t k = 0; length != 0; ++k, length >>= 1) {
+                if(length & 0x1u) {
+                    crc = multiply(crc, m_Powers[k]);
+                }
+            }
+            return crc;
+        }
+
+        // a * b mod P
+        [[nodiscard]] static constexpr TAccumulator multiply(TAccumulator a, TAccumulator b)
+        {
+            TAccumulator product = 0;
+            for(std::size_t degree = 0; degree < traits::ACCUMULATOR_BITS; ++degree) {
+                if(policy::has_term(a, degree)) {
+                    product ^= b;
+                }
+                b = policy::multiply_x(b, POLYNOMIAL);
+            }
+            return product;
+        }
+
+    private:
+        static constexpr std::size_t POWERS = sizeof(std::size_t) * 8;
+        using powers_type = std::array<TAccumulator, POWERS>;
+
+        [[nodiscard]] static constexpr powers_type Generate()
+        {
+            powers_type powers{};
+
+            // x^8
+            TAccumulator x8 = policy::unity();
+            for(std::size_t i = 0; i < 8; ++i) {
+                x8 = policy::multiply_x(x8, POLYNOMIAL);
+            }
+
+            powers[0] = x8;
+            for(std::size_t k = 1; k < POWERS; ++k) {
+                powers[k] = multiply(powers[k - 1], powers[k - 1]);
+            }
+
+            return powers;
+        }
+
+        static constexpr powers_type m_Powers = Generate();
+    };
+
+    //
+    // Lookup tables for messages of a fixed length N.
+    //
+    // Each chunk of each byte position gets its own table holding that chunk's contribution to
+    // the final register, so the CRC is the xor of independent lookups with no dependency chain
+    // between bytes. The initial value and final xor are folded into a single constant.
+    //
+    template <typename TAccumulator,
+              TAccumulator const POLYNOMIAL,
+              TAccumulator const INITIAL,
+              TAccumulator const XOR_OUT,
+              bool const REVERSE,
+              table_size const TABLE_SIZE,
+              std::size_t const N>
+    class crc_fixed_table
+    {
+    public:
+        using table_impl = crc_chunk_table<TAccumulator, POLYNOMIAL, REVERSE, TABLE_SIZE>;
+        using traits = typename table_impl::traits;
+
+        static constexpr std::size_t CHUNKS = 8 / traits::CHUNK_BITS;   // per byte
+        static constexpr std::size_t LOOKUPS = N * CHUNKS;
+
+        template<typename TData, std::size_t ...INDEX>
+        [[nodiscard]] static constexpr TAccumulator compute(TData const &data, std::index_sequence<INDEX...>)
+        {
+            TAccumulator crc = 0;
+            ((crc ^= m_Tables[INDEX][(util_byte(data[INDEX / CHUNKS]) >> ((INDEX % CHUNKS) * traits::CHUNK_BITS)) & traits::CHUNK_MASK]), ...);
+
+            if constexpr(CONSTANT != 0) {
+                crc ^= CONSTANT;
+            }
+            return crc;
+        }
+
+    private:
+        using tables_type = std::array<typename traits::table_type, LOOKUPS>;
+
+        [[nodiscard]] static constexpr uint8_t util_byte(uint8_t value) { return value; }
+        [[nodiscard]] static constexpr uint8_t util_byte(std::byte value) { return std::to_integer<uint8_t>(value); }
+
+        [[nodiscard]] static constexpr tables_type Generate()
+        {
+            tables_type tables{};
+
+            // the last byte: a single chunk from a zero register
+            for(std::size_t chunk = 0; chunk < CHUNKS; ++chunk) {
+                for(std::size_t value = 0; value < traits::TABLE_ENTRIES; ++value) {
+                    tables[(N - 1) * CHUNKS + chunk][value] =
+                            table_impl::update(0, static_cast<uint8_t>(value << (chunk * traits::CHUNK_BITS)));
+                }
+            }
+
+            // each earlier byte is followed by one more zero byte
+            for(std::size_t position = N - 1; position-- > 0;) {
+                for(std::size_t chunk = 0; chunk < CHUNKS; ++chunk) {
+                    for(std::size_t value = 0; value < traits::TABLE_ENTRIES; ++value) {
+                        tables[position * CHUNKS + chunk][value] = table_impl::update(tables[(position + 1) * CHUNKS + chunk][value], 0);
+                    }
+                }
+            }
+
+            return tables;
+        }
+
+        // the initial register clocked through N bytes, plus the final xor
+        static constexpr TAccumulator CONSTANT = static_cast<TAccumulator>(
+                crc_shift<TAccumulator, POLYNOMIAL, REVERSE>::shift(table_impl::make_initial_value(INITIAL), N) ^ XOR_OUT);
+
+        static constexpr tables_type m_Tables = Generate();
+    };
+
     //
     // Define the CRC algorithm parameters
     //
@@ -399,17 +626,65 @@ namespace impl
     //
     // The generic CRC accumulator that is table driven
     //
-    template <typename TAlgorithm, const table_size TABLE_SIZE>
+    // The optional instrumentation policy observes every update call, the default
+    // records nothing and adds no code or storage.
+    //
+    template <typename TAlgorithm, const table_size TABLE_SIZE, typename TInstrumentation = instrument::disabled>
     class crc
     {
         public:
             using algorithm = TAlgorithm;
             using accumulator_type = typename algorithm::accumulator_type;
+            using instrumentation = TInstrumentation;
+            static constexpr table_size table = TABLE_SIZE;
 
             //
             // Update the accumulator with a new byte
             //
-            constexpr void update(uint8_t value) { m_Crc = table_impl::update(m_Crc, value); }
+            constexpr void update(uint8_t value)
+            {
+                if constexpr(instrumentation::enabled) {
+                    if(!util::is_constant_evaluated()) {
+                        instrumentation::template record<algorithm, TABLE_SIZE>(1, instrument::engine::per_byte,
+                                [&]() { m_Crc = table_impl::update(m_Crc, value); });
+                        return;
+                    }
+                }
+
+                m_Crc = table_impl::update(m_Crc, value);
+            }
+
+            //
+            // Update the accumulator with a block of bytes
+            //
+            constexpr void update(uint8_t const *data, std::size_t length)
+            {
+                if constexpr(instrumentation::enabled) {
+                    if(!util::is_constant_evaluated()) {
+                        instrumentation::template record<algorithm, TABLE_SIZE>(length, instrument::engine::bulk,
+                                [&]() { m_Crc = update_block(m_Crc, data, length); });
+                        return;
+                    }
+                }
+
+                m_Crc = update_block(m_Crc, data, length);
+            }
+
+            //
+            // Update the accumulator with a run of zero bytes in O(log length)
+            //
+            constexpr void update_zeros(std::size_t length)
+            {
+                if constexpr(instrumentation::enabled) {
+                    if(!util::is_constant_evaluated()) {
+                        instrumentation::template record<algorithm, TABLE_SIZE>(length, instrument::engine::zeros,
+                                [&]() { m_Crc = shift_impl::shift(m_Crc, length); });
+                        return;
+                    }
+                }
+
+                m_Crc = shift_impl::shift(m_Crc, length);
+            }
 
             //
             // Extract the final value of the accumulator.
@@ -424,6 +699,16 @@ namespace impl
 
         private:
             using table_impl = crc_chunk_table<accumulator_type, algorithm::polynomial, algorithm::reverse, TABLE_SIZE>;
+            using shift_impl = crc_shift<accumulator_type, algorithm::polynomial, algorithm::reverse>;
+
+            [[nodiscard]] static constexpr accumulator_type update_block(
+                    accumulator_type crc, uint8_t const *data, std::size_t length)
+            {
+                for(std::size_t i = 0; i < length; ++i) {
+                    crc = table_impl::update(crc, data[i]);
+                }
+                return crc;
+            }
 
             accumulator_type m_Crc = table_impl::make_initial_value(algorithm::initial_value);
     };
@@ -734,6 +1019,146 @@ namespace tiny
 
 }   // namespace tiny
 
+    //------------------------------------------------------------------------
+    //
+    // Combine the final CRCs of two consecutive blocks A and B into the CRC of
+    // A followed by B, given only the length of B. Runs in O(log length_b).
+    //
+    //------------------------------------------------------------------------
+    template <typename TCrc>
+    [[nodiscard]] constexpr typename TCrc::accumulator_type combine(
+            typename TCrc::accumulator_type crc_a, typename TCrc::accumulator_type crc_b, std::size_t length_b)
+    {
+        using algorithm = typename TCrc::algorithm;
+        using accumulator_type = typename TCrc::accumulator_type;
+        using shift = impl::crc_shift<accumulator_type, algorithm::polynomial, algorithm::reverse>;
+
+        // Shifting the register of A over B's length and adding B's contribution from a zero
+        // register gives the combined register. The initial value's contribution to B is
+        // cancelled by adding it into A's register before the shift.
+        auto const initial = shift::policy::make_initial_value(algorithm::initial_value);
+        auto const register_a = static_cast<accumulator_type>(crc_a ^ algorithm::xor_out_value ^ initial);
+
+        return static_cast<accumulator_type>(shift::shift(register_a, length_b) ^ crc_b);
+    }
+
+    //------------------------------------------------------------------------
+    //
+    // Compute the CRC of a message whose length is known at compile time,
+    // such as a fixed size header.
+    //
+    // The calculation is fully unrolled. Up to FIXED_TABLE_LIMIT bytes each
+    // byte position has its own lookup tables (sized by the CRC's table_size)
+    // so the lookups are independent. Longer messages use the CRC's table
+    // directly.
+    //
+    //------------------------------------------------------------------------
+    constexpr std::size_t FIXED_TABLE_LIMIT = 32;
+
+namespace impl
+{
+    template <typename TCrc, std::size_t N, typename TData>
+    [[nodiscard]] constexpr typename TCrc::accumulator_type compute_fixed(TData const &data)
+    {
+        using algorithm = typename TCrc::algorithm;
+        using accumulator_type = typename TCrc::accumulator_type;
+
+        if constexpr(N <= FIXED_TABLE_LIMIT) {
+            using fixed_table = crc_fixed_table<accumulator_type, algorithm::polynomial, algorithm::initial_value,
+                                                algorithm::xor_out_value, algorithm::reverse, TCrc::table, N>;
+            return fixed_table::compute(data, std::make_index_sequence<fixed_table::LOOKUPS>{});
+        } else {
+            TCrc crc;
+            for(std::size_t i = 0; i < N; ++i) {
+                crc.update(static_cast<uint8_t>(data[i]));
+            }
+            return crc.final();
+        }
+    }
+}   // namespace impl
+
+    template <typename TCrc, std::size_t N>
+    [[nodiscard]] constexpr typename TCrc::accumulator_type compute_fixed(std::byte const (&data)[N])
+    {
+        return impl::compute_fixed<TCrc, N>(data);
+    }
+
+    template <typename TCrc, std::size_t N>
+    [[nodiscard]] constexpr typename TCrc::accumulator_type compute_fixed(std::array<std::byte, N> const &data)
+    {
+        return impl::compute_fixed<TCrc, N>(data);
+    }
+
+    template <typename TCrc, std::size_t N>
+    [[nodiscard]] constexpr typename TCrc::accumulator_type compute_fixed(std::array<uint8_t, N> const &data)
+    {
+        return impl::compute_fixed<TCrc, N>(data);
+    }
+
+    //------------------------------------------------------------------------
+    //
+    // Compute several CRCs over the same data in a single pass.
+    //
+    // The data is walked in blocks small enough to stay in the L1 cache and
+    // each block is fed to every accumulator's bulk update, so the data is
+    // read from memory once and instrumented accumulators see bulk calls.
+    //
+    //   crc_cpp::multi<crc_cpp::crc32, crc_cpp::large::crc32_c> crc;
+    //   crc.update(data, length);
+    //   auto [container, storage] = crc.final();
+    //
+    //------------------------------------------------------------------------
+    template <typename... TCrcs>
+    class multi
+    {
+        static_assert(sizeof...(TCrcs) > 0, "At least one CRC is required");
+
+        public:
+            using result_type = std::tuple<typename TCrcs::accumulator_type...>;
+
+            //
+            // Update all accumulators with a new byte
+            //
+            constexpr void update(uint8_t value)
+            {
+                std::apply([value](auto &... crc) { (crc.update(value), ...); }, m_Crcs);
+            }
+
+            //
+            // Update all accumulators with a block of bytes
+            //
+            constexpr void update(uint8_t const *data, std::size_t length)
+            {
+                std::apply([data, length](auto &... crc) {
+                    for(std::size_t offset = 0; offset < length; offset += BLOCK_SIZE) {
+                        auto const count = length - offset < BLOCK_SIZE ? length - offset : BLOCK_SIZE;
+                        (crc.update(data + offset, count), ...);
+                    }
+                }, m_Crcs);
+            }
+
+            //
+            // Extract the final value of every accumulator, in template argument order.
+            //
+            [[nodiscard]] constexpr result_type final()
+            {
+                return std::apply([](auto &... crc) { return result_type{crc.final()...}; }, m_Crcs);
+            }
+
+            //
+            // Reset the state of all accumulators back to their INITIAL values.
+            //
+            constexpr void reset()
+            {
+                std::apply([](auto &... crc) { (crc.reset(), ...); }, m_Crcs);
+            }
+
+        private:
+            static constexpr std::size_t BLOCK_SIZE = 4 * 1024;
+
+            std::tuple<TCrcs...> m_Crcs;
+    };
+
 }   // namespace crc_cpp
 
 #undef CRC_CPP_STD20_MODE
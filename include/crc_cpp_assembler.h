@@ -0,0 +1,169 @@
+#ifndef CRC_CPP_ASSEMBLER_H_INCLUDED
+#define CRC_CPP_ASSEMBLER_H_INCLUDED
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Ashley Roll
+ * https://github.com/AshleyRoll/crc_cpp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Out of order CRC assembly.
+//
+// Chunks of a message can be added in any order, from any thread. Only the CRC
+// of each contiguous covered range is kept, never the data. When a chunk makes
+// two ranges adjacent they are merged with combine(), and once the whole
+// message is covered the CRC is available.
+//
+
+#include "crc_cpp.h"
+
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+
+
+namespace crc_cpp
+{
+    template <typename TCrc>
+    class assembler
+    {
+        public:
+            using algorithm = typename TCrc::algorithm;
+            using accumulator_type = typename TCrc::accumulator_type;
+
+            explicit assembler(std::size_t total_length) : m_Length(total_length) {}
+
+            //
+            // Add a chunk of the message at offset. The CRC of the chunk is computed before taking the lock,
+            // so concurrent callers run in parallel.
+            //
+            // Returns false (and ignores the chunk) if it extends past the end or overlaps data already added.
+            //
+            bool add(std::size_t offset, uint8_t const *data, std::size_t length)
+            {
+                if(offset > m_Length || length > m_Length - offset) {
+                    return false;
+                }
+                if(length == 0) {
+                    return true;
+                }
+
+                TCrc crc;
+                crc.update(data, length);
+                range chunk{length, crc.final()};
+
+                std::lock_guard<std::mutex> guard(m_Lock);
+
+                // the first range starting after the chunk, and the one before it
+                auto next = m_Ranges.upper_bound(offset);
+                if(next != m_Ranges.end() && next->first < offset + length) {
+                    return false;
+                }
+
+                if(next != m_Ranges.begin()) {
+                    auto previous = std::prev(next);
+                    auto const previous_end = previous->first + previous->second.length;
+                    if(previous_end > offset) {
+                        return false;
+                    }
+
+                    if(previous_end == offset) {
+                        // extend the previous range with the chunk
+                        previous->second = merge(previous->second, chunk);
+                        chunk = previous->second;
+                        offset = previous->first;
+                        m_Ranges.erase(previous);
+                    }
+                }
+
+                if(next != m_Ranges.end() && next->first == offset + chunk.length) {
+                    chunk = merge(chunk, next->second);
+                    m_Ranges.erase(next);
+                }
+
+                m_Ranges.emplace(offset, chunk);
+                return true;
+            }
+
+            //
+            // True once every byte of the message has been added
+            //
+            [[nodiscard]] bool complete() const
+            {
+                std::lock_guard<std::mutex> guard(m_Lock);
+                return is_complete();
+            }
+
+            //
+            // The CRC of the whole message, or nothing while there are still gaps
+            //
+            [[nodiscard]] std::optional<accumulator_type> final() const
+            {
+                std::lock_guard<std::mutex> guard(m_Lock);
+                if(!is_complete()) {
+                    return std::nullopt;
+                }
+                if(m_Length == 0) {
+                    TCrc crc;
+                    return crc.final();
+                }
+                return m_Ranges.begin()->second.crc;
+            }
+
+            //
+            // Number of disjoint ranges currently held
+            //
+            [[nodiscard]] std::size_t ranges() const
+            {
+                std::lock_guard<std::mutex> guard(m_Lock);
+                return m_Ranges.size();
+            }
+
+        private:
+            struct range
+            {
+                std::size_t length;
+                accumulator_type crc;   // the CRC of the range on its own
+            };
+
+            [[nodiscard]] static range merge(range const &first, range const &second)
+            {
+                return range{first.length + second.length, combine<TCrc>(first.crc, second.crc, second.length)};
+            }
+
+            [[nodiscard]] bool is_complete() const
+            {
+                if(m_Length == 0) {
+                    return true;
+                }
+                return m_Ranges.size() == 1 && m_Ranges.begin()->first == 0 && m_Ranges.begin()->second.length == m_Length;
+            }
+
+            std::size_t m_Length;
+            mutable std::mutex m_Lock;
+            std::map<std::size_t, range> m_Ranges;   // disjoint, non adjacent ranges keyed by offset
+    };
+
+}   // namespace crc_cpp
+
+#endif // CRC_CPP_ASSEMBLER_H_INCLUDED
@@ -0,0 +1,341 @@
+#ifndef CRC_CPP_BATCH_H_INCLUDED
+#define CRC_CPP_BATCH_H_INCLUDED
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Ashley Roll
+ * https://github.com/AshleyRoll/crc_cpp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Batch CRC: many independent streams of the same algorithm advanced in lockstep.
+//
+// This uses the 16 entry (small) nibble table. Each lane's accumulator is stored
+// "planar", one byte per vector register, so a nibble step is a byte shuffle
+// (pshufb / vpshufb) per accumulator byte with the table held in registers.
+// With SSSE3 a register holds 16 lanes, with AVX2 32 lanes.
+//
+// Without SSSE3 a portable scalar implementation is used.
+//
+
+#include "crc_cpp.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CRC_CPP_BATCH_SIMD 2
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define CRC_CPP_BATCH_SIMD 1
+#endif
+
+
+namespace crc_cpp
+{
+namespace impl
+{
+    //
+    // The small table split into one 16 byte table per accumulator byte
+    //
+    template <typename TAlgorithm>
+    struct nibble_planes
+    {
+        using accumulator_type = typename TAlgorithm::accumulator_type;
+        using policy = typename std::conditional<TAlgorithm::reverse,
+                crc_reverse_policy<accumulator_type, table_size::small>,
+                crc_forward_policy<accumulator_type, table_size::small>>::type;
+
+        static constexpr std::size_t PLANES = sizeof(accumulator_type);
+        static constexpr std::size_t ENTRIES = policy::traits::TABLE_ENTRIES;
+
+        using table_type = std::array<std::array<uint8_t, ENTRIES>, PLANES>;
+
+        [[nodiscard]] static constexpr table_type generate()
+        {
+            table_type table{};
+
+            for(std::size_t nibble = 0; nibble < ENTRIES; ++nibble) {
+                auto const entry = policy::generate_entry(TAlgorithm::polynomial, static_cast<uint8_t>(nibble));
+                for(std::size_t plane = 0; plane < PLANES; ++plane) {
+                    table[plane][nibble] = static_cast<uint8_t>(entry >> (plane * 8));
+                }
+            }
+
+            return table;
+        }
+
+        static constexpr table_type table = generate();
+    };
+
+#ifdef CRC_CPP_BATCH_SIMD
+    //
+    // Byte lane vector operations used by the nibble engine
+    //
+    struct simd_128
+    {
+        using reg = __m128i;
+        static constexpr std::size_t WIDTH = 16;
+
+        static reg load(uint8_t const *p) { return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p)); }
+        static void store(uint8_t *p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+        static reg load_table(uint8_t const *p) { return load(p); }
+        static reg lookup(reg table, reg index) { return _mm_shuffle_epi8(table, index); }
+        static reg bit_xor(reg a, reg b) { return _mm_xor_si128(a, b); }
+        static reg bit_or(reg a, reg b) { return _mm_or_si128(a, b); }
+        static reg low_nibble(reg v) { return _mm_and_si128(v, _mm_set1_epi8(0x0F)); }
+        static reg high_nibble(reg v) { return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F)); }
+        static reg shift_up(reg v) { return _mm_and_si128(_mm_slli_epi16(v, 4), _mm_set1_epi8(static_cast<char>(0xF0))); }
+    };
+
+#if CRC_CPP_BATCH_SIMD >= 2
+    struct simd_256
+    {
+        using reg = __m256i;
+        static constexpr std::size_t WIDTH = 32;
+
+        static reg load(uint8_t const *p) { return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p)); }
+        static void store(uint8_t *p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+        // vpshufb looks up within each 128 bit half, so the table is repeated in both
+        static reg load_table(uint8_t const *p) { return _mm256_broadcastsi128_si256(simd_128::load(p)); }
+        static reg lookup(reg table, reg index) { return _mm256_shuffle_epi8(table, index); }
+        static reg bit_xor(reg a, reg b) { return _mm256_xor_si256(a, b); }
+        static reg bit_or(reg a, reg b) { return _mm256_or_si256(a, b); }
+        static reg low_nibble(reg v) { return _mm256_and_si256(v, _mm256_set1_epi8(0x0F)); }
+        static reg high_nibble(reg v) { return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F)); }
+        static reg shift_up(reg v) { return _mm256_and_si256(_mm256_slli_epi16(v, 4), _mm256_set1_epi8(static_cast<char>(0xF0))); }
+    };
+#endif
+
+    //
+    // Advance WIDTH lanes by one byte each. The accumulator is held as PLANES byte registers,
+    // plane 0 being the least significant byte.
+    //
+    template <typename TAlgorithm, typename TSimd>
+    struct nibble_engine
+    {
+        using planes = nibble_planes<TAlgorithm>;
+        using reg = typename TSimd::reg;
+
+        // a plain array, std::array<> would drop the vector type's alignment attributes
+        struct state_type
+        {
+            reg plane[planes::PLANES];
+        };
+
+        [[nodiscard]] static state_type load_tables()
+        {
+            state_type tables;
+            for(std::size_t plane = 0; plane < planes::PLANES; ++plane) {
+                tables.plane[plane] = TSimd::load_table(planes::table[plane].data());
+            }
+            return tables;
+        }
+
+        static void update(state_type &state, state_type const &tables, reg value)
+        {
+            if constexpr(TAlgorithm::reverse) {
+                update_nibble(state, tables, TSimd::low_nibble(value));
+                update_nibble(state, tables, TSimd::high_nibble(value));
+            } else {
+                update_nibble(state, tables, TSimd::high_nibble(value));
+                update_nibble(state, tables, TSimd::low_nibble(value));
+            }
+        }
+
+        static void update_nibble(state_type &state, state_type const &tables, reg nibble)
+        {
+            constexpr std::size_t TOP = planes::PLANES - 1;
+
+            if constexpr(TAlgorithm::reverse) {
+                // index with the least significant nibble then shift the accumulator right 4 bits
+                auto const index = TSimd::bit_xor(TSimd::low_nibble(state.plane[0]), nibble);
+                for(std::size_t plane = 0; plane < TOP; ++plane) {
+                    state.plane[plane] = TSimd::bit_or(TSimd::high_nibble(state.plane[plane]), TSimd::shift_up(state.plane[plane + 1]));
+                }
+                state.plane[TOP] = TSimd::high_nibble(state.plane[TOP]);
+
+                for(std::size_t plane = 0; plane < planes::PLANES; ++plane) {
+                    state.plane[plane] = TSimd::bit_xor(state.plane[plane], TSimd::lookup(tables.plane[plane], index));
+                }
+            } else {
+                // index with the most significant nibble then shift the accumulator left 4 bits
+                auto const index = TSimd::bit_xor(TSimd::high_nibble(state.plane[TOP]), nibble);
+                for(std::size_t plane = TOP; plane > 0; --plane) {
+                    state.plane[plane] = TSimd::bit_or(TSimd::shift_up(state.plane[plane]), TSimd::high_nibble(state.plane[plane - 1]));
+                }
+                state.plane[0] = TSimd::shift_up(state.plane[0]);
+
+                for(std::size_t plane = 0; plane < planes::PLANES; ++plane) {
+                    state.plane[plane] = TSimd::bit_xor(state.plane[plane], TSimd::lookup(tables.plane[plane], index));
+                }
+            }
+        }
+    };
+
+    // the widest vector that does not exceed the number of lanes
+#if CRC_CPP_BATCH_SIMD >= 2
+    template <std::size_t LANES>
+    using batch_simd = typename std::conditional<(LANES >= simd_256::WIDTH), simd_256, simd_128>::type;
+#else
+    template <std::size_t LANES>
+    using batch_simd = simd_128;
+#endif
+#endif  // CRC_CPP_BATCH_SIMD
+
+}   // namespace impl
+
+    //------------------------------------------------------------------------
+    //
+    // LANES independent CRC accumulators of the same algorithm that are
+    // updated together, one byte per lane per step.
+    //
+    //------------------------------------------------------------------------
+    template <typename TAlgorithm, std::size_t LANES = 16>
+    class batch
+    {
+        static_assert(LANES == 16 || LANES == 32, "Batches are 16 or 32 lanes wide");
+
+        public:
+            using algorithm = TAlgorithm;
+            using accumulator_type = typename algorithm::accumulator_type;
+            static constexpr std::size_t lanes = LANES;
+
+            batch() { reset(); }
+
+            //
+            // Update every lane from interleaved data: byte i of lane l is at data[i * LANES + l]
+            //
+            void update_interleaved(uint8_t const *data, std::size_t steps)
+            {
+                run(steps, [data](std::size_t step, std::size_t first_lane, uint8_t const *&row, std::array<uint8_t, LANES> &) {
+                    row = data + step * LANES + first_lane;
+                });
+            }
+
+            //
+            // Update every lane from its own buffer, all of the same length
+            //
+            void update(std::array<uint8_t const *, LANES> const &data, std::size_t length)
+            {
+                run(length, [&data](std::size_t step, std::size_t first_lane, uint8_t const *&row, std::array<uint8_t, LANES> &gather) {
+                    for(std::size_t lane = 0; lane < LANES; ++lane) {
+                        gather[lane] = data[lane][step];
+                    }
+                    row = gather.data() + first_lane;
+                });
+            }
+
+            //
+            // Extract the final value of a single lane
+            //
+            [[nodiscard]] accumulator_type final(std::size_t lane) const
+            {
+                accumulator_type crc = 0;
+                for(std::size_t plane = 0; plane < PLANES; ++plane) {
+                    accumulator_type const byte = m_State[plane][lane];
+                    crc = static_cast<accumulator_type>(crc | (byte << (plane * 8)));
+                }
+                return crc ^ algorithm::xor_out_value;
+            }
+
+            //
+            // Extract the final value of every lane
+            //
+            [[nodiscard]] std::array<accumulator_type, LANES> final() const
+            {
+                std::array<accumulator_type, LANES> result{};
+                for(std::size_t lane = 0; lane < LANES; ++lane) {
+                    result[lane] = final(lane);
+                }
+                return result;
+            }
+
+            //
+            // Reset every lane back to the INITIAL value.
+            //
+            void reset()
+            {
+                auto const init = table_impl::make_initial_value(algorithm::initial_value);
+                for(std::size_t plane = 0; plane < PLANES; ++plane) {
+                    m_State[plane].fill(static_cast<uint8_t>(init >> (plane * 8)));
+                }
+            }
+
+        private:
+            using table_impl = impl::crc_chunk_table<accumulator_type, algorithm::polynomial, algorithm::reverse, table_size::small>;
+            static constexpr std::size_t PLANES = sizeof(accumulator_type);
+
+            // planar state, m_State[plane][lane] is byte "plane" of the lane's accumulator
+            std::array<std::array<uint8_t, LANES>, PLANES> m_State{};
+
+            template <typename TRowSource>
+            void run(std::size_t steps, TRowSource &&source)
+            {
+                std::array<uint8_t, LANES> gather{};
+                uint8_t const *row = nullptr;
+
+#ifdef CRC_CPP_BATCH_SIMD
+                using simd = impl::batch_simd<LANES>;
+                using engine = impl::nibble_engine<algorithm, simd>;
+
+                auto const tables = engine::load_tables();
+
+                for(std::size_t first = 0; first < LANES; first += simd::WIDTH) {
+                    typename engine::state_type state;
+                    for(std::size_t plane = 0; plane < PLANES; ++plane) {
+                        state.plane[plane] = simd::load(m_State[plane].data() + first);
+                    }
+
+                    for(std::size_t step = 0; step < steps; ++step) {
+                        source(step, first, row, gather);
+                        engine::update(state, tables, simd::load(row));
+                    }
+
+                    for(std::size_t plane = 0; plane < PLANES; ++plane) {
+                        simd::store(m_State[plane].data() + first, state.plane[plane]);
+                    }
+                }
+#else
+                std::array<accumulator_type, LANES> crc{};
+                for(std::size_t lane = 0; lane < LANES; ++lane) {
+                    crc[lane] = static_cast<accumulator_type>(final(lane) ^ algorithm::xor_out_value);
+                }
+
+                for(std::size_t step = 0; step < steps; ++step) {
+                    source(step, 0, row, gather);
+                    for(std::size_t lane = 0; lane < LANES; ++lane) {
+                        crc[lane] = table_impl::update(crc[lane], row[lane]);
+                    }
+                }
+
+                for(std::size_t lane = 0; lane < LANES; ++lane) {
+                    for(std::size_t plane = 0; plane < PLANES; ++plane) {
+                        m_State[plane][lane] = static_cast<uint8_t>(crc[lane] >> (plane * 8));
+                    }
+                }
+#endif
+            }
+    };
+
+}   // namespace crc_cpp
+
+#undef CRC_CPP_BATCH_SIMD
+
+#endif // CRC_CPP_BATCH_H_INCLUDED
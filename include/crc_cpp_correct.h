@@ -0,0 +1,270 @@
+#ifndef CRC_CPP_CORRECT_H_INCLUDED
+#define CRC_CPP_CORRECT_H_INCLUDED
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Ashley Roll
+ * https://github.com/AshleyRoll/crc_cpp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Single and double bit error correction for short frames.
+//
+// A CRC is linear, so the difference between the computed and received CRC
+// (the syndrome) depends only on which bits were flipped and how far they are
+// from the end of the frame. We generate a syndrome -> bit position hash table
+// at compile time, so correcting a frame costs one CRC plus one table probe.
+//
+
+#include "crc_cpp.h"
+
+
+namespace crc_cpp
+{
+    enum class correction
+    {
+        no_error,       // the CRC matched
+        corrected,      // the frame (or the received CRC) had correctable errors which were fixed
+        uncorrectable   // too many errors, the frame was not modified
+    };
+
+namespace impl
+{
+    //
+    // Compile time syndrome lookup table for frames of up to MAX_LEN bytes.
+    //
+    // Bit positions are counted from the end of the frame. Positions below ACCUMULATOR_BITS
+    // are bits of the received CRC value, the remainder are data bits:
+    //
+    //   position = ACCUMULATOR_BITS + 8 * (bytes from the end of the data) + bit
+    //
+    template <typename TAlgorithm, std::size_t MAX_LEN, std::size_t MAX_ERRORS>
+    class syndrome_table
+    {
+    public:
+        using accumulator_type = typename TAlgorithm::accumulator_type;
+
+        static constexpr std::size_t ACCUMULATOR_BITS = sizeof(accumulator_type) * 8;
+        static constexpr std::size_t POSITIONS = MAX_LEN * 8 + ACCUMULATOR_BITS;
+        static constexpr uint16_t NO_POSITION = 0xFFFFu;
+
+        static_assert(MAX_ERRORS == 1 || MAX_ERRORS == 2, "Only single and double bit errors can be corrected");
+        static_assert(POSITIONS < NO_POSITION, "MAX_LEN is too large");
+
+        struct match
+        {
+            bool found;
+            uint16_t first;
+            uint16_t second;    // NO_POSITION for single bit errors
+        };
+
+        //
+        // Find the bit positions that explain a (non zero) syndrome
+        //
+        [[nodiscard]] static constexpr match lookup(accumulator_type syndrome)
+        {
+            for(std::size_t slot = slot_of(syndrome);; slot = (slot + 1) & (CAPACITY - 1)) {
+                auto const &e = m_Table.slots[slot];
+                if(!e.used) {
+                    return match{false, NO_POSITION, NO_POSITION};
+                }
+                if(e.syndrome == syndrome) {
+                    return match{true, e.first, e.second};
+                }
+            }
+        }
+
+        // false if two error patterns share a syndrome, i.e. MAX_LEN is beyond the correction capability
+        static constexpr bool valid() { return m_Table.unique; }
+
+    private:
+        static constexpr std::size_t ENTRIES = POSITIONS + (MAX_ERRORS > 1 ? POSITIONS * (POSITIONS - 1) / 2 : 0);
+
+        [[nodiscard]] static constexpr std::size_t capacity_bits()
+        {
+            // keep the load factor at or below 50%
+            std::size_t bits = 1;
+            while((std::size_t{1} << bits) < ENTRIES * 2) {
+                ++bits;
+            }
+            return bits;
+        }
+
+        static constexpr std::size_t CAPACITY_BITS = capacity_bits();
+        static constexpr std::size_t CAPACITY = std::size_t{1} << CAPACITY_BITS;
+        static_assert(CAPACITY_BITS < 32, "Syndrome table too large");
+
+        struct entry
+        {
+            accumulator_type syndrome;
+            uint16_t first;
+            uint16_t second;
+            bool used;
+        };
+
+        struct table_data
+        {
+            std::array<entry, CAPACITY> slots{};
+            bool unique = true;
+        };
+
+        [[nodiscard]] static constexpr std::size_t slot_of(accumulator_type syndrome)
+        {
+            // fold to 32 bits then fibonacci hash, taking the top bits of the product
+            uint64_t const wide = syndrome;
+            auto const folded = static_cast<uint32_t>(wide ^ (wide >> 32));
+            uint32_t const hash = folded * 0x9E3779B9u;
+            return hash >> (32 - CAPACITY_BITS);
+        }
+
+        static constexpr void insert(table_data &t, accumulator_type syndrome, uint16_t first, uint16_t second)
+        {
+            if(syndrome == 0) {
+                // indistinguishable from an error free frame
+                t.unique = false;
+                return;
+            }
+
+            std::size_t slot = slot_of(syndrome);
+            while(t.slots[slot].used) {
+                if(t.slots[slot].syndrome == syndrome) {
+                    t.unique = false;
+                    return;
+                }
+                slot = (slot + 1) & (CAPACITY - 1);
+            }
+
+            t.slots[slot] = entry{syndrome, first, second, true};
+        }
+
+        [[nodiscard]] static constexpr table_data generate()
+        {
+            using table_impl = crc_chunk_table<accumulator_type, TAlgorithm::polynomial, TAlgorithm::reverse, table_size::small>;
+
+            std::array<accumulator_type, POSITIONS> single{};
+
+            // an error in the received CRC changes the syndrome by that bit alone
+            for(std::size_t bit = 0; bit < ACCUMULATOR_BITS; ++bit) {
+                single[bit] = static_cast<accumulator_type>(accumulator_type{1u} << bit);
+            }
+
+            // an error in a data byte is clocked through the register by the bytes that follow it
+            std::array<accumulator_type, 8> column{};
+            for(std::size_t bit = 0; bit < 8; ++bit) {
+                column[bit] = table_impl::update(0, static_cast<uint8_t>(1u << bit));
+            }
+
+            for(std::size_t byte = 0; byte < MAX_LEN; ++byte) {
+                for(std::size_t bit = 0; bit < 8; ++bit) {
+                    single[ACCUMULATOR_BITS + byte * 8 + bit] = column[bit];
+                    column[bit] = table_impl::update(column[bit], 0);
+                }
+            }
+
+            table_data t{};
+            for(std::size_t p = 0; p < POSITIONS; ++p) {
+                insert(t, single[p], static_cast<uint16_t>(p), NO_POSITION);
+            }
+
+            if constexpr(MAX_ERRORS > 1) {
+                for(std::size_t p = 0; p < POSITIONS; ++p) {
+                    for(std::size_t q = p + 1; q < POSITIONS; ++q) {
+                        insert(t, static_cast<accumulator_type>(single[p] ^ single[q]), static_cast<uint16_t>(p), static_cast<uint16_t>(q));
+                    }
+                }
+            }
+
+            return t;
+        }
+
+        static constexpr table_data m_Table = generate();
+    };
+
+}   // namespace impl
+
+    //
+    // Check a frame against its received CRC and correct up to MAX_ERRORS (1 or 2) flipped bits.
+    //
+    // TCrc is the CRC implementation (eg crc_cpp::crc16_x25) and MAX_LEN is the longest frame
+    // (excluding the CRC) that will be corrected. Compilation fails if the polynomial cannot
+    // uniquely identify every error pattern at that length.
+    //
+    // On return of correction::corrected the data has been repaired in place. If the error was in the
+    // received CRC itself the data is left unchanged.
+    //
+    // The syndrome table is generated at compile time and stored in .rodata. It has a slot for each
+    // error pattern, 8 * MAX_LEN + W single bit positions plus every pair of them for MAX_ERRORS = 2,
+    // at no more than 50% load rounded up to a power of two. Double error tables grow with the square
+    // of MAX_LEN. Measured with g++ 12 for MAX_ERRORS = 2:
+    //
+    //   crc32      MAX_LEN 8     16384 slots   192 KB    1.3M constexpr operations   0.5s
+    //   crc32      MAX_LEN 16    32768 slots   384 KB    3.8M                        1.1s
+    //   crc32      MAX_LEN 32   131072 slots   1.5 MB   11.9M                        3.8s
+    //   crc64_ecma MAX_LEN 16    65536 slots     1 MB    6.3M                        1.9s
+    //
+    // Single bit tables are small, eg crc32 with MAX_LEN 64 is 2048 slots (24 KB). GCC's default
+    // limit is 2^25 operations. Clang counts coarser steps against a default -fconstexpr-steps of
+    // 1048576; these tables have not been measured there, raise the limit if evaluation fails.
+    //
+    template <typename TCrc, std::size_t MAX_LEN, std::size_t MAX_ERRORS = 1>
+    [[nodiscard]] constexpr correction correct(uint8_t *data, std::size_t length, typename TCrc::accumulator_type received)
+    {
+        using table = impl::syndrome_table<typename TCrc::algorithm, MAX_LEN, MAX_ERRORS>;
+        static_assert(table::valid(), "CRC polynomial cannot correct this many errors in frames of MAX_LEN");
+
+        if(length > MAX_LEN) {
+            return correction::uncorrectable;
+        }
+
+        TCrc crc;
+        crc.update(data, length);
+
+        auto const syndrome = static_cast<typename TCrc::accumulator_type>(crc.final() ^ received);
+        if(syndrome == 0) {
+            return correction::no_error;
+        }
+
+        auto const m = table::lookup(syndrome);
+        if(!m.found) {
+            return correction::uncorrectable;
+        }
+
+        // the table covers MAX_LEN, reject positions that lie before the start of a shorter frame
+        auto const frame_bits = table::ACCUMULATOR_BITS + length * 8;
+        if(m.first >= frame_bits || (m.second != table::NO_POSITION && m.second >= frame_bits)) {
+            return correction::uncorrectable;
+        }
+
+        for(auto const position : {m.first, m.second}) {
+            if(position == table::NO_POSITION || position < table::ACCUMULATOR_BITS) {
+                continue;   // nothing to do, or the error is in the received CRC
+            }
+
+            auto const offset = position - table::ACCUMULATOR_BITS;
+            data[length - 1 - offset / 8] ^= static_cast<uint8_t>(1u << (offset % 8));
+        }
+
+        return correction::corrected;
+    }
+
+}   // namespace crc_cpp
+
+#endif // CRC_CPP_CORRECT_H_INCLUDED
@@ -0,0 +1,182 @@
+#ifndef CRC_CPP_EMBED_H_INCLUDED
+#define CRC_CPP_EMBED_H_INCLUDED
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Ashley Roll
+ * https://github.com/AshleyRoll/crc_cpp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// CRCs of embedded binary resources.
+//
+// compute_constant() is a bulk CRC intended for compile time evaluation of large
+// inputs: it consumes 16 bytes per step with a slice by 16 table lookup, and
+// splits the work into nested loops to stay under GCC's per loop iteration limit.
+// cmake/EmbedResource.cmake generates a header holding a resource and its CRCs
+// as constexpr constants, and verify_async() checks the resource against them
+// off the start up path.
+//
+
+#include "crc_cpp.h"
+
+#include <future>
+
+
+namespace crc_cpp
+{
+namespace impl
+{
+    //
+    // Slice by 16 update for compile time evaluation. Compilers charge every evaluated expression
+    // against their constexpr budget, so each byte of a slice is looked up directly in a plain array
+    // by its distance from the end of the slice, with the register folded into the leading bytes.
+    // With g++ 12 this costs about 20 operations per byte, against about 120 for update().
+    //
+    template <typename TAlgorithm>
+    class crc_bulk
+    {
+    public:
+        using accumulator_type = typename TAlgorithm::accumulator_type;
+
+        static constexpr std::size_t SLICE = 16;
+
+        [[nodiscard]] static constexpr accumulator_type update(accumulator_type crc, uint8_t const *data, std::size_t length)
+        {
+            // GCC also limits the iterations of each loop, so walk the slices in segments
+            std::size_t const slices = length / SLICE;
+            for(std::size_t segment = 0; segment < slices; segment += SEGMENT_SLICES) {
+                std::size_t const count = slices - segment < SEGMENT_SLICES ? slices - segment : SEGMENT_SLICES;
+                uint8_t const *p = data + segment * SLICE;
+                uint8_t const *const end = p + count * SLICE;
+                for(; p != end; p += SLICE) {
+                    crc = update_slice(crc, p, std::make_index_sequence<ACCUMULATOR_BYTES>{},
+                                       std::make_index_sequence<SLICE - ACCUMULATOR_BYTES>{});
+                }
+            }
+
+            for(std::size_t i = slices * SLICE; i < length; ++i) {
+                crc = table_impl::update(crc, data[i]);
+            }
+            return crc;
+        }
+
+    private:
+        static constexpr std::size_t ACCUMULATOR_BYTES = sizeof(accumulator_type);
+        static constexpr std::size_t SEGMENT_SLICES = 64 * 1024;
+
+        using table_impl = crc_chunk_table<accumulator_type, TAlgorithm::polynomial, TAlgorithm::reverse, table_size::large>;
+
+        static_assert(ACCUMULATOR_BYTES < SLICE, "The register must fit in a slice");
+
+        // tables[k][b] is byte b followed by k zero bytes, clocked from a zero register
+        struct tables_type
+        {
+            accumulator_type entries[SLICE][256];
+        };
+
+        [[nodiscard]] static constexpr tables_type Generate()
+        {
+            tables_type tables{};
+            for(std::size_t value = 0; value < 256; ++value) {
+                tables.entries[0][value] = table_impl::update(0, static_cast<uint8_t>(value));
+                for(std::size_t k = 1; k < SLICE; ++k) {
+                    tables.entries[k][value] = table_impl::update(tables.entries[k - 1][value], 0);
+                }
+            }
+            return tables;
+        }
+
+        static constexpr tables_type m_Tables = Generate();
+
+        // the register byte that lines up with byte INDEX of the slice
+        template <std::size_t INDEX>
+        static constexpr std::size_t REGISTER_SHIFT = TAlgorithm::reverse ? INDEX * 8 : (ACCUMULATOR_BYTES - 1 - INDEX) * 8;
+
+        // the slice shifts the whole register out, so its bytes are folded into the first data bytes
+        template <std::size_t ...HEAD, std::size_t ...TAIL>
+        [[nodiscard]] static constexpr accumulator_type update_slice(accumulator_type crc, uint8_t const *data,
+                                                                      std::index_sequence<HEAD...>, std::index_sequence<TAIL...>)
+        {
+            return static_cast<accumulator_type>(
+                    (m_Tables.entries[SLICE - 1 - HEAD][data[HEAD] ^ static_cast<uint8_t>(crc >> REGISTER_SHIFT<HEAD>)] ^ ...) ^
+                    (0 ^ ... ^ m_Tables.entries[SLICE - 1 - ACCUMULATOR_BYTES - TAIL][data[ACCUMULATOR_BYTES + TAIL]]));
+        }
+    };
+
+}   // namespace impl
+
+    //------------------------------------------------------------------------
+    //
+    // Compute the CRC of a block of data in one call, suited to compile time
+    // evaluation of large embedded resources.
+    //
+    //------------------------------------------------------------------------
+    template <typename TCrc>
+    [[nodiscard]] constexpr typename TCrc::accumulator_type compute_constant(uint8_t const *data, std::size_t length)
+    {
+        using algorithm = typename TCrc::algorithm;
+
+        auto const initial = impl::crc_chunk_table<typename algorithm::accumulator_type, algorithm::polynomial,
+                                                   algorithm::reverse, table_size::large>::make_initial_value(algorithm::initial_value);
+
+        return static_cast<typename TCrc::accumulator_type>(
+                impl::crc_bulk<algorithm>::update(initial, data, length) ^ algorithm::xor_out_value);
+    }
+
+    template <typename TCrc, std::size_t N>
+    [[nodiscard]] constexpr typename TCrc::accumulator_type compute_constant(uint8_t const (&data)[N])
+    {
+        return compute_constant<TCrc>(data, N);
+    }
+
+    //------------------------------------------------------------------------
+    //
+    // Check a resource against its expected CRC off the critical path.
+    //
+    // With std::launch::async the check runs on another thread straight away,
+    // with std::launch::deferred it runs when the result is first requested,
+    // for example from an idle loop. The data must outlive the future.
+    //
+    //------------------------------------------------------------------------
+    template <typename TCrc>
+    [[nodiscard]] std::future<bool> verify_async(uint8_t const *data, std::size_t length,
+                                                 typename TCrc::accumulator_type expected,
+                                                 std::launch policy = std::launch::async)
+    {
+        return std::async(policy, [data, length, expected]() {
+            TCrc crc;
+            crc.update(data, length);
+            return crc.final() == expected;
+        });
+    }
+
+    template <typename TCrc, std::size_t N>
+    [[nodiscard]] std::future<bool> verify_async(uint8_t const (&data)[N],
+                                                 typename TCrc::accumulator_type expected,
+                                                 std::launch policy = std::launch::async)
+    {
+        return verify_async<TCrc>(data, N, expected, policy);
+    }
+
+}   // namespace crc_cpp
+
+#endif // CRC_CPP_EMBED_H_INCLUDED
@@ -0,0 +1,171 @@
+#ifndef CRC_CPP_FILE_H_INCLUDED
+#define CRC_CPP_FILE_H_INCLUDED
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Ashley Roll
+ * https://github.com/AshleyRoll/crc_cpp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// CRC of a whole file.
+//
+// Where the platform supports SEEK_DATA / SEEK_HOLE, holes in sparse files are
+// skipped with update_zeros(), so the cost is proportional to the data in the
+// file rather than its apparent size. Otherwise the file is read sequentially.
+//
+
+#include "crc_cpp.h"
+
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace crc_cpp
+{
+namespace impl
+{
+    constexpr std::size_t FILE_BUFFER_SIZE = 64 * 1024;
+
+    // read the remainder of a stream into the crc
+    template <typename TCrc>
+    [[nodiscard]] bool update_from_stream(TCrc &crc, std::istream &in)
+    {
+        std::vector<char> buffer(FILE_BUFFER_SIZE);
+        while(in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || in.gcount() > 0) {
+            crc.update(reinterpret_cast<uint8_t const *>(buffer.data()), static_cast<std::size_t>(in.gcount()));
+        }
+        return in.eof();
+    }
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    enum class sparse_read
+    {
+        done,
+        failed,
+        unsupported     // the file system does not support SEEK_DATA, read the file normally
+    };
+
+    //
+    // Walk the data extents of a sparse file, treating the holes as zero runs.
+    //
+    template <typename TCrc>
+    [[nodiscard]] sparse_read update_from_sparse_file(TCrc &crc, std::string const &path)
+    {
+        int const fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return sparse_read::failed;
+        }
+
+        struct stat info{};
+        if(::fstat(fd, &info) != 0) {
+            ::close(fd);
+            return sparse_read::failed;
+        }
+
+        std::vector<uint8_t> buffer(FILE_BUFFER_SIZE);
+        off_t const size = info.st_size;
+        off_t position = 0;
+        sparse_read result = sparse_read::done;
+
+        while(position < size) {
+            off_t data = ::lseek(fd, position, SEEK_DATA);
+            if(data < 0) {
+                if(errno != ENXIO) {
+                    result = position == 0 ? sparse_read::unsupported : sparse_read::failed;
+                    break;
+                }
+                data = size;   // only a hole remains
+            }
+
+            crc.update_zeros(static_cast<std::size_t>(data - position));
+
+            off_t hole = ::lseek(fd, data, SEEK_HOLE);
+            if(hole < 0 || hole > size) {
+                hole = size;
+            }
+
+            for(position = data; position < hole;) {
+                auto const wanted = static_cast<std::size_t>(std::min<off_t>(hole - position, static_cast<off_t>(buffer.size())));
+                auto const got = ::pread(fd, buffer.data(), wanted, position);
+                if(got <= 0) {
+                    result = sparse_read::failed;
+                    break;
+                }
+                crc.update(buffer.data(), static_cast<std::size_t>(got));
+                position += got;
+            }
+
+            if(result != sparse_read::done) {
+                break;
+            }
+        }
+
+        ::close(fd);
+        return result;
+    }
+#endif
+
+}   // namespace impl
+
+    //------------------------------------------------------------------------
+    //
+    // Compute the CRC of a file, skipping holes in sparse files where the
+    // platform allows. Returns nothing if the file cannot be read.
+    //
+    //------------------------------------------------------------------------
+    template <typename TCrc>
+    [[nodiscard]] std::optional<typename TCrc::accumulator_type> file_crc(std::string const &path)
+    {
+        TCrc crc;
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+        switch(impl::update_from_sparse_file(crc, path)) {
+            case impl::sparse_read::done:
+                return crc.final();
+            case impl::sparse_read::failed:
+                return std::nullopt;
+            case impl::sparse_read::unsupported:
+                crc.reset();
+                break;
+        }
+#endif
+
+        std::ifstream file(path, std::ios::binary);
+        if(!file || !impl::update_from_stream(crc, file)) {
+            return std::nullopt;
+        }
+        return crc.final();
+    }
+
+}   // namespace crc_cpp
+
+#endif // CRC_CPP_FILE_H_INCLUDED
@@ -0,0 +1,472 @@
+#ifndef CRC_CPP_MANIFEST_H_INCLUDED
+#define CRC_CPP_MANIFEST_H_INCLUDED
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Ashley Roll
+ * https://github.com/AshleyRoll/crc_cpp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Per-block CRC manifests.
+//
+// A manifest records the CRC of every fixed size block of a file (or buffer)
+// so blocks can be built and verified in parallel, and so a partial rewrite
+// only needs the dirty blocks to be recomputed. The whole-file CRC is derived
+// by combining the block CRCs.
+//
+// Sidecar format (all integers little endian):
+//
+//   offset  size   field
+//   0       4      magic "CRCM"
+//   4       1      format version (1)
+//   5       1      accumulator width in bytes
+//   6       1      reverse (0 or 1)
+//   7       1      reserved (0)
+//   8       8      polynomial
+//   16      8      initial value
+//   24      8      xor out value
+//   32      8      block size
+//   40      8      total length
+//   48      width  whole-file CRC
+//   ...     width  one CRC per block, ceil(total length / block size) blocks
+//
+
+#include "crc_cpp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace crc_cpp
+{
+    template <typename TCrc>
+    class manifest
+    {
+        public:
+            using algorithm = typename TCrc::algorithm;
+            using accumulator_type = typename TCrc::accumulator_type;
+
+            // returned by verify when every block matches
+            static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+            //
+            // Build a manifest of a buffer using up to "threads" threads (0 = hardware concurrency)
+            //
+            [[nodiscard]] static manifest build(uint8_t const *data, std::size_t length, std::size_t block_size, std::size_t threads = 1)
+            {
+                manifest m(block_size, length);
+                m.compute(0, m.block_count(), threads, memory_source{data, length, m.block_size()}, [&m](std::size_t index, std::optional<accumulator_type> crc) {
+                    m.m_Blocks[index] = crc.value_or(accumulator_type{0});
+                });
+                return m;
+            }
+
+            //
+            // Build a manifest of a file. Returns nothing if the file cannot be read.
+            //
+            [[nodiscard]] static std::optional<manifest> build_file(std::string const &path, std::size_t block_size, std::size_t threads = 1)
+            {
+                auto const length = file_length(path);
+                if(!length) {
+                    return std::nullopt;
+                }
+
+                manifest m(block_size, *length);
+                std::atomic<bool> failed{false};
+                m.compute(0, m.block_count(), threads, file_source{path, *length, m.block_size()}, [&m, &failed](std::size_t index, std::optional<accumulator_type> crc) {
+                    if(crc) {
+                        m.m_Blocks[index] = *crc;
+                    } else {
+                        failed = true;
+                    }
+                });
+
+                if(failed) {
+                    return std::nullopt;
+                }
+                return m;
+            }
+
+            //
+            // Verify a buffer against the manifest. Returns the index of the first mismatching block or npos.
+            // A length difference is reported at the block where the lengths diverge.
+            //
+            [[nodiscard]] std::size_t verify(uint8_t const *data, std::size_t length, std::size_t threads = 1) const
+            {
+                return verify_blocks(0, block_count(), length, threads, memory_source{data, length, m_BlockSize});
+            }
+
+            //
+            // Verify only the blocks overlapping [offset, offset + count), eg after a partial rewrite.
+            //
+            [[nodiscard]] std::size_t verify_range(uint8_t const *data, std::size_t length, std::size_t offset, std::size_t count, std::size_t threads = 1) const
+            {
+                auto const [first, last] = block_range(offset, count);
+                return verify_blocks(first, last, length, threads, memory_source{data, length, m_BlockSize});
+            }
+
+            //
+            // Verify a file against the manifest. Unreadable blocks are reported as mismatches.
+            //
+            [[nodiscard]] std::size_t verify_file(std::string const &path, std::size_t threads = 1) const
+            {
+                auto const length = file_length(path);
+                if(!length) {
+                    return 0;
+                }
+                return verify_blocks(0, block_count(), *length, threads, file_source{path, *length, m_BlockSize});
+            }
+
+            [[nodiscard]] std::size_t verify_file_range(std::string const &path, std::size_t offset, std::size_t count, std::size_t threads = 1) const
+            {
+                auto const length = file_length(path);
+                if(!length) {
+                    return 0;
+                }
+                auto const [first, last] = block_range(offset, count);
+                return verify_blocks(first, last, *length, threads, file_source{path, *length, m_BlockSize});
+            }
+
+            //
+            // Recompute the blocks overlapping [offset, offset + count) after the data was rewritten.
+            // The buffer may have changed length, in which case every block from the old end onward
+            // is also recomputed.
+            //
+            void update(uint8_t const *data, std::size_t length, std::size_t offset, std::size_t count, std::size_t threads = 1)
+            {
+                auto [first, last] = block_range(offset, count);
+                if(length != m_Length) {
+                    first = std::min(first, std::min(m_Length, length) / m_BlockSize);
+                    m_Length = length;
+                    m_Blocks.resize(blocks_for(length));
+                    last = block_count();
+                }
+                last = std::min(last, block_count());
+
+                compute(first, last, threads, memory_source{data, length, m_BlockSize}, [this](std::size_t index, std::optional<accumulator_type> crc) {
+                    m_Blocks[index] = crc.value_or(accumulator_type{0});
+                });
+            }
+
+            //
+            // The CRC of the whole file, combined from the block CRCs
+            //
+            [[nodiscard]] accumulator_type file_crc() const
+            {
+                TCrc crc;
+                auto result = crc.final();
+                for(std::size_t i = 0; i < block_count(); ++i) {
+                    result = combine<TCrc>(result, m_Blocks[i], block_length(i, m_Length));
+                }
+                return result;
+            }
+
+            [[nodiscard]] std::size_t block_size() const { return m_BlockSize; }
+            [[nodiscard]] std::size_t length() const { return m_Length; }
+            [[nodiscard]] std::size_t block_count() const { return m_Blocks.size(); }
+            [[nodiscard]] accumulator_type block_crc(std::size_t index) const { return m_Blocks[index]; }
+
+            //
+            // Encode in the sidecar format
+            //
+            [[nodiscard]] std::vector<uint8_t> serialize() const
+            {
+                std::vector<uint8_t> out;
+                out.reserve(HEADER_SIZE + (block_count() + 1) * WIDTH);
+
+                put(out, MAGIC, 4);
+                put(out, VERSION, 1);
+                put(out, WIDTH, 1);
+                put(out, algorithm::reverse ? 1 : 0, 1);
+                put(out, 0, 1);
+                put(out, algorithm::polynomial, 8);
+                put(out, algorithm::initial_value, 8);
+                put(out, algorithm::xor_out_value, 8);
+                put(out, m_BlockSize, 8);
+                put(out, m_Length, 8);
+                put(out, file_crc(), WIDTH);
+                for(auto const crc : m_Blocks) {
+                    put(out, crc, WIDTH);
+                }
+
+                return out;
+            }
+
+            //
+            // Decode the sidecar format. Returns nothing if it is malformed or for a different algorithm.
+            //
+            [[nodiscard]] static std::optional<manifest> deserialize(uint8_t const *data, std::size_t length)
+            {
+                if(length < HEADER_SIZE + WIDTH
+                        || get(data, 4) != MAGIC
+                        || data[4] != VERSION || data[5] != WIDTH || data[6] != (algorithm::reverse ? 1u : 0u)
+                        || get(data + 8, 8) != algorithm::polynomial
+                        || get(data + 16, 8) != algorithm::initial_value
+                        || get(data + 24, 8) != algorithm::xor_out_value) {
+                    return std::nullopt;
+                }
+
+                auto const block_size = get(data + 32, 8);
+                auto const total = get(data + 40, 8);
+                if(block_size == 0 || block_size > SIZE_MAX || total > SIZE_MAX) {
+                    return std::nullopt;
+                }
+
+                // check the block CRCs are all present before allocating space for them, the division
+                // keeps a hostile length field from overflowing
+                auto const blocks = total / block_size + (total % block_size != 0 ? 1 : 0);
+                auto const stored = length - HEADER_SIZE;
+                if(stored % WIDTH != 0 || stored / WIDTH - 1 != blocks) {
+                    return std::nullopt;
+                }
+
+                manifest m(static_cast<std::size_t>(block_size), static_cast<std::size_t>(total));
+
+                for(std::size_t i = 0; i < m.block_count(); ++i) {
+                    m.m_Blocks[i] = static_cast<accumulator_type>(get(data + HEADER_SIZE + (i + 1) * WIDTH, WIDTH));
+                }
+
+                // the stored whole-file CRC must agree with the blocks
+                if(static_cast<accumulator_type>(get(data + HEADER_SIZE, WIDTH)) != m.file_crc()) {
+                    return std::nullopt;
+                }
+
+                return m;
+            }
+
+            //
+            // Sidecar file helpers
+            //
+            [[nodiscard]] bool save(std::string const &path) const
+            {
+                auto const bytes = serialize();
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<char const *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+                return static_cast<bool>(file);
+            }
+
+            [[nodiscard]] static std::optional<manifest> load(std::string const &path)
+            {
+                std::ifstream file(path, std::ios::binary);
+                std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                if(!file.eof()) {
+                    return std::nullopt;
+                }
+                return deserialize(bytes.data(), bytes.size());
+            }
+
+        private:
+            static constexpr uint32_t MAGIC = 0x4D435243;  // "CRCM"
+            static constexpr uint8_t VERSION = 1;
+            static constexpr uint8_t WIDTH = sizeof(accumulator_type);
+            static constexpr std::size_t HEADER_SIZE = 48;
+
+            std::size_t m_BlockSize;
+            std::size_t m_Length;
+            std::vector<accumulator_type> m_Blocks;
+
+            manifest(std::size_t block_size, std::size_t length)
+                : m_BlockSize(block_size == 0 ? 1 : block_size)
+                , m_Length(length)
+                , m_Blocks(blocks_for(length))
+            {}
+
+            [[nodiscard]] std::size_t blocks_for(std::size_t length) const
+            {
+                return length / m_BlockSize + (length % m_BlockSize != 0 ? 1 : 0);
+            }
+
+            [[nodiscard]] std::size_t block_length(std::size_t index, std::size_t length) const
+            {
+                auto const start = index * m_BlockSize;
+                return start >= length ? 0 : std::min(m_BlockSize, length - start);
+            }
+
+            [[nodiscard]] std::pair<std::size_t, std::size_t> block_range(std::size_t offset, std::size_t count) const
+            {
+                auto const first = offset / m_BlockSize;
+                if(count == 0) {
+                    // an empty range at offset, so a length change alone starts from the old or new end
+                    auto const at = std::min(first, block_count());
+                    return {at, at};
+                }
+                auto const last = (offset + count - 1) / m_BlockSize + 1;
+                return {std::min(first, block_count()), std::min(last, block_count())};
+            }
+
+            static void put(std::vector<uint8_t> &out, uint64_t value, std::size_t bytes)
+            {
+                for(std::size_t i = 0; i < bytes; ++i) {
+                    out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+                }
+            }
+
+            [[nodiscard]] static uint64_t get(uint8_t const *in, std::size_t bytes)
+            {
+                uint64_t value = 0;
+                for(std::size_t i = 0; i < bytes; ++i) {
+                    value |= static_cast<uint64_t>(in[i]) << (i * 8);
+                }
+                return value;
+            }
+
+            [[nodiscard]] static std::optional<std::size_t> file_length(std::string const &path)
+            {
+                std::ifstream file(path, std::ios::binary | std::ios::ate);
+                if(!file) {
+                    return std::nullopt;
+                }
+                auto const end = file.tellg();
+                if(end < 0) {
+                    return std::nullopt;
+                }
+                return static_cast<std::size_t>(end);
+            }
+
+            //
+            // Block sources. Each worker thread makes its own reader, which returns the CRC of a block
+            // or nothing if the block could not be read.
+            //
+            struct memory_source
+            {
+                uint8_t const *data;
+                std::size_t length;
+                std::size_t block_size;
+
+                [[nodiscard]] auto make_reader() const
+                {
+                    return [*this](std::size_t index, std::size_t block_length) -> std::optional<accumulator_type> {
+                        TCrc crc;
+                        crc.update(data + index * block_size, block_length);
+                        return crc.final();
+                    };
+                }
+            };
+
+            struct file_source
+            {
+                std::string path;
+                std::size_t length;
+                std::size_t block_size;
+
+                [[nodiscard]] auto make_reader() const
+                {
+                    return [file = std::ifstream(path, std::ios::binary), buffer = std::vector<char>(block_size), size = block_size](
+                                   std::size_t index, std::size_t block_length) mutable -> std::optional<accumulator_type> {
+                        file.seekg(static_cast<std::streamoff>(index * size));
+                        file.read(buffer.data(), static_cast<std::streamsize>(block_length));
+                        if(!file) {
+                            file.clear();
+                            return std::nullopt;
+                        }
+
+                        TCrc crc;
+                        crc.update(reinterpret_cast<uint8_t const *>(buffer.data()), block_length);
+                        return crc.final();
+                    };
+                }
+            };
+
+            //
+            // Compute the CRC of blocks [first, last), handing each to sink(index, crc).
+            // Blocks are split into contiguous ranges, one per thread.
+            //
+            template <typename TSource, typename TSink>
+            void compute(std::size_t first, std::size_t last, std::size_t threads, TSource const &source, TSink &&sink) const
+            {
+                for_each_range(first, last, threads, [&](std::size_t begin, std::size_t end) {
+                    auto reader = source.make_reader();
+                    for(std::size_t i = begin; i < end; ++i) {
+                        sink(i, reader(i, block_length(i, source.length)));
+                    }
+                });
+            }
+
+            template <typename TSource>
+            [[nodiscard]] std::size_t verify_blocks(std::size_t first, std::size_t last, std::size_t length, std::size_t threads, TSource const &source) const
+            {
+                // when the length has changed, blocks from the one where the lengths diverge onward cannot match
+                std::size_t mismatch = npos;
+                if(length != m_Length) {
+                    auto const diverged = std::max(first, std::min(length, m_Length) / m_BlockSize);
+                    if(diverged < last || last == block_count()) {
+                        mismatch = diverged;
+                        last = std::min(last, diverged);
+                    }
+                }
+
+                std::atomic<std::size_t> first_mismatch{mismatch};
+                for_each_range(first, last, threads, [&](std::size_t begin, std::size_t end) {
+                    auto reader = source.make_reader();
+                    for(std::size_t i = begin; i < end && i < first_mismatch.load(std::memory_order_relaxed); ++i) {
+                        auto const crc = reader(i, block_length(i, length));
+                        if(!crc || *crc != m_Blocks[i]) {
+                            auto current = first_mismatch.load();
+                            while(i < current && !first_mismatch.compare_exchange_weak(current, i)) {
+                            }
+                            return;
+                        }
+                    }
+                });
+
+                return first_mismatch;
+            }
+
+            template <typename TWork>
+            static void for_each_range(std::size_t first, std::size_t last, std::size_t threads, TWork &&work)
+            {
+                if(last <= first) {
+                    return;
+                }
+
+                auto const blocks = last - first;
+                if(threads == 0) {
+                    threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+                }
+                threads = std::min(threads, blocks);
+
+                if(threads == 1) {
+                    work(first, last);
+                    return;
+                }
+
+                std::vector<std::thread> workers;
+                workers.reserve(threads);
+                for(std::size_t t = 0; t < threads; ++t) {
+                    auto const begin = first + blocks * t / threads;
+                    auto const end = first + blocks * (t + 1) / threads;
+                    workers.emplace_back([&work, begin, end]() { work(begin, end); });
+                }
+                for(auto &w : workers) {
+                    w.join();
+                }
+            }
+    };
+
+}   // namespace crc_cpp
+
+#endif // CRC_CPP_MANIFEST_H_INCLUDED
@@ -0,0 +1,321 @@
+#ifndef CRC_CPP_TELEMETRY_H_INCLUDED
+#define CRC_CPP_TELEMETRY_H_INCLUDED
+/*
+ * MIT License
+ *
+ * Copyright (c) 2020 Ashley Roll
+ * https://github.com/AshleyRoll/crc_cpp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+//
+// Opt-in runtime telemetry for crc_cpp.
+//
+// Select the policy as the instrumentation parameter of impl::crc:
+//
+//   using crc32 = crc_cpp::impl::crc<crc_cpp::alg::crc32, crc_cpp::table_size::large,
+//                                    crc_cpp::telemetry::counters>;
+//
+// Each thread accumulates into its own counters with plain relaxed stores, so
+// the hot path takes no locks. A lock is only taken the first time a thread
+// uses an algorithm, when it exits, and when a snapshot is taken.
+//
+
+#include "crc_cpp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CRC_CPP_TELEMETRY_HAS_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define CRC_CPP_TELEMETRY_HAS_TSC 1
+#endif
+
+
+namespace crc_cpp
+{
+namespace telemetry
+{
+    // log2 buckets: bucket i counts values in [2^i, 2^(i+1)), bucket 0 also holds 0
+    constexpr std::size_t HISTOGRAM_BUCKETS = 32;
+    constexpr std::size_t ENGINE_COUNT = static_cast<std::size_t>(instrument::engine::count);
+
+    using histogram = std::array<uint64_t, HISTOGRAM_BUCKETS>;
+
+    //
+    // Accumulated counters for one algorithm / table size
+    //
+    struct totals
+    {
+        uint64_t calls = 0;
+        uint64_t bytes = 0;
+        uint64_t ticks = 0;                                 // only recorded by timed policies
+        std::array<uint64_t, ENGINE_COUNT> engine_calls{};  // indexed by instrument::engine
+        histogram call_size{};                              // bytes per call
+        histogram latency{};                                // ticks per call, only recorded by timed policies
+    };
+
+    //
+    // Describes the algorithm a set of totals belongs to
+    //
+    struct algorithm_info
+    {
+        std::size_t width = 0;
+        uint64_t polynomial = 0;
+        uint64_t initial_value = 0;
+        uint64_t xor_out_value = 0;
+        bool reverse = false;
+        table_size table = table_size::undefined;
+    };
+
+    struct record
+    {
+        algorithm_info info;
+        totals counts;
+    };
+
+    //
+    // Tick source for timed policies. Uses the TSC where available, otherwise steady_clock nanoseconds.
+    //
+    [[nodiscard]] inline uint64_t ticks()
+    {
+#ifdef CRC_CPP_TELEMETRY_HAS_TSC
+        return static_cast<uint64_t>(__rdtsc());
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    [[nodiscard]] constexpr std::size_t bucket_of(uint64_t value)
+    {
+        std::size_t bucket = 0;
+        while(value > 1 && bucket < HISTOGRAM_BUCKETS - 1) {
+            value >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+namespace detail
+{
+    //
+    // Counters owned by a single thread. Only the owner writes, so a relaxed
+    // load/store pair is enough and readers never see torn values.
+    //
+    struct thread_counters
+    {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> ticks{0};
+        std::array<std::atomic<uint64_t>, ENGINE_COUNT> engine_calls{};
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> call_size{};
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> latency{};
+
+        static void add(std::atomic<uint64_t> &counter, uint64_t value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        void add_call(std::size_t length, instrument::engine e)
+        {
+            add(calls, 1);
+            add(bytes, length);
+            add(engine_calls[static_cast<std::size_t>(e)], 1);
+            add(call_size[bucket_of(length)], 1);
+        }
+
+        void add_ticks(uint64_t elapsed)
+        {
+            add(ticks, elapsed);
+            add(latency[bucket_of(elapsed)], 1);
+        }
+
+        void accumulate_into(totals &t) const
+        {
+            t.calls += calls.load(std::memory_order_relaxed);
+            t.bytes += bytes.load(std::memory_order_relaxed);
+            t.ticks += ticks.load(std::memory_order_relaxed);
+            for(std::size_t i = 0; i < ENGINE_COUNT; ++i) {
+                t.engine_calls[i] += engine_calls[i].load(std::memory_order_relaxed);
+            }
+            for(std::size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+                t.call_size[i] += call_size[i].load(std::memory_order_relaxed);
+                t.latency[i] += latency[i].load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    //
+    // Per algorithm registry of live thread counters, plus totals from threads that have exited.
+    //
+    struct algorithm_entry
+    {
+        algorithm_info info;
+        std::mutex lock;
+        std::vector<thread_counters const *> live;
+        totals retired;
+
+        [[nodiscard]] totals snapshot()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            totals result = retired;
+            for(auto const *c : live) {
+                c->accumulate_into(result);
+            }
+            return result;
+        }
+    };
+
+    struct registry
+    {
+        std::mutex lock;
+        std::vector<algorithm_entry *> entries;
+    };
+
+    [[nodiscard]] inline registry &global_registry()
+    {
+        static registry r;
+        return r;
+    }
+
+    template<typename TAlgorithm, table_size TABLE_SIZE>
+    [[nodiscard]] algorithm_entry &entry()
+    {
+        static algorithm_entry *e = []() {
+            static algorithm_entry storage;
+            storage.info.width = sizeof(typename TAlgorithm::accumulator_type) * 8;
+            storage.info.polynomial = TAlgorithm::polynomial;
+            storage.info.initial_value = TAlgorithm::initial_value;
+            storage.info.xor_out_value = TAlgorithm::xor_out_value;
+            storage.info.reverse = TAlgorithm::reverse;
+            storage.info.table = TABLE_SIZE;
+
+            auto &r = global_registry();
+            std::lock_guard<std::mutex> guard(r.lock);
+            r.entries.push_back(&storage);
+            return &storage;
+        }();
+        return *e;
+    }
+
+    //
+    // Thread local counters that register with the algorithm entry on first use
+    // and fold themselves into the retired totals on thread exit.
+    //
+    template<typename TAlgorithm, table_size TABLE_SIZE>
+    struct registered_counters
+    {
+        thread_counters counters;
+
+        registered_counters()
+        {
+            auto &e = entry<TAlgorithm, TABLE_SIZE>();
+            std::lock_guard<std::mutex> guard(e.lock);
+            e.live.push_back(&counters);
+        }
+
+        ~registered_counters()
+        {
+            auto &e = entry<TAlgorithm, TABLE_SIZE>();
+            std::lock_guard<std::mutex> guard(e.lock);
+            counters.accumulate_into(e.retired);
+            e.live.erase(std::remove(e.live.begin(), e.live.end(), &counters), e.live.end());
+        }
+
+        registered_counters(registered_counters const &) = delete;
+        registered_counters &operator=(registered_counters const &) = delete;
+    };
+
+    template<typename TAlgorithm, table_size TABLE_SIZE>
+    [[nodiscard]] thread_counters &local()
+    {
+        thread_local registered_counters<TAlgorithm, TABLE_SIZE> c;
+        return c.counters;
+    }
+
+}   // namespace detail
+
+    //
+    // Instrumentation policy recording calls, bytes, engine and call size histogram.
+    // TIMED additionally records per call latency in ticks.
+    //
+    template<bool TIMED>
+    struct basic_counters
+    {
+        static constexpr bool enabled = true;
+
+        template<typename TAlgorithm, table_size TABLE_SIZE, typename TWork>
+        static void record(std::size_t bytes, instrument::engine e, TWork &&work)
+        {
+            auto &c = detail::local<TAlgorithm, TABLE_SIZE>();
+
+            if constexpr(TIMED) {
+                auto const start = ticks();
+                work();
+                c.add_ticks(ticks() - start);
+            } else {
+                work();
+            }
+
+            c.add_call(bytes, e);
+        }
+    };
+
+    using counters = basic_counters<false>;
+    using timed_counters = basic_counters<true>;
+
+    //
+    // Snapshot the totals for a single algorithm across all threads.
+    //
+    template<typename TAlgorithm, table_size TABLE_SIZE>
+    [[nodiscard]] totals snapshot()
+    {
+        return detail::entry<TAlgorithm, TABLE_SIZE>().snapshot();
+    }
+
+    //
+    // Snapshot the totals for every instrumented algorithm that has been used.
+    //
+    [[nodiscard]] inline std::vector<record> snapshot_all()
+    {
+        auto &r = detail::global_registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+
+        std::vector<record> result;
+        result.reserve(r.entries.size());
+        for(auto *e : r.entries) {
+            result.push_back(record{e->info, e->snapshot()});
+        }
+        return result;
+    }
+
+}   // namespace telemetry
+}   // namespace crc_cpp
+
+#undef CRC_CPP_TELEMETRY_HAS_TSC
+
+#endif // CRC_CPP_TELEMETRY_H_INCLUDED
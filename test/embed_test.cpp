@@ -0,0 +1,23 @@
+#include "crc_cpp_embed.h"
+
+#include <catch2/catch_all.hpp>
+
+#include "large_resource.h"   // generated by CRC_CPP_EMBED_RESOURCE
+
+//
+// A resource of several MB, so the constexpr budget the embed helper sets for the target is checked
+// at the sizes it is meant for. This is slow to build, so it is only added to the main test target
+// with ENABLE_LARGE_EMBED_TEST.
+//
+static_assert(sizeof(resources::large_resource) > 4 * 1000 * 1000, "The large resource should be several MB");
+
+TEST_CASE("LargeEmbeddedResource", "TestCRC")
+{
+    crc_cpp::crc32 reflected;
+    reflected.update(resources::large_resource, sizeof(resources::large_resource));
+    REQUIRE(resources::large_resource_crc32 == reflected.final());
+
+    crc_cpp::crc64_ecma forward;
+    forward.update(resources::large_resource, sizeof(resources::large_resource));
+    REQUIRE(resources::large_resource_crc64_ecma == forward.final());
+}
@@ -1,9 +1,23 @@
 #include "crc_cpp.h"
+#include "crc_cpp_assembler.h"
+#include "crc_cpp_batch.h"
+#include "crc_cpp_correct.h"
+#include "crc_cpp_embed.h"
+#include "crc_cpp_file.h"
+#include "crc_cpp_manifest.h"
+#include "crc_cpp_telemetry.h"
 
+#include <algorithm>
 #include <array>
 #include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 #include <vector>
 
+#include "license.h"   // generated by CRC_CPP_EMBED_RESOURCE
+
 using namespace crc_cpp;
 
 template<typename T> bool is_expected(T const result, T const expected)
@@ -143,3 +157,543 @@ TEST_CASE("Algorithm", "TestCRC")
 
     REQUIRE(test_crc<family::crc64_ecma>( message, 0x6C40DF5F0B497347U));
 }
+
+TEST_CASE("BulkUpdate", "TestCRC")
+{
+    const std::vector<uint8_t> message{ '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+    crc_cpp::crc32 crc;
+    crc.update(message.data(), 4);
+    crc.update(message.data() + 4, message.size() - 4);
+    REQUIRE(crc.final() == 0xCBF43926);
+}
+
+TEST_CASE("Telemetry", "TestInstrumentation")
+{
+    using instrumented = impl::crc<alg::crc16_x25, table_size::small, telemetry::timed_counters>;
+    static_assert(sizeof(instrumented) == sizeof(instrumented::accumulator_type), "Instrumentation must not add state");
+
+    const std::vector<uint8_t> message{ '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    auto const before = telemetry::snapshot<alg::crc16_x25, table_size::small>();
+
+    instrumented crc;
+    crc.update(message[0]);
+    crc.update(message.data() + 1, message.size() - 1);
+    REQUIRE(crc.final() == 0x906E);
+
+    auto const after = telemetry::snapshot<alg::crc16_x25, table_size::small>();
+    REQUIRE(after.calls - before.calls == 2);
+    REQUIRE(after.bytes - before.bytes == message.size());
+    REQUIRE(after.engine_calls[static_cast<std::size_t>(instrument::engine::per_byte)]
+            - before.engine_calls[static_cast<std::size_t>(instrument::engine::per_byte)] == 1);
+    REQUIRE(after.call_size[telemetry::bucket_of(8)] - before.call_size[telemetry::bucket_of(8)] == 1);
+
+    auto const all = telemetry::snapshot_all();
+    REQUIRE(std::any_of(all.begin(), all.end(), [](auto const &r) {
+        return r.info.width == 16 && r.info.polynomial == 0x1021 && r.info.reverse && r.counts.calls >= 2;
+    }));
+}
+
+//
+// Flip every single bit (and optionally every pair of bits) of the message and check it is corrected
+//
+template<typename TCrc, std::size_t MAX_LEN, std::size_t MAX_ERRORS>
+bool test_correct(std::vector<uint8_t> const& message, typename TCrc::accumulator_type expected)
+{
+    bool status = true;
+    auto const bits = message.size() * 8;
+
+    for (std::size_t i = 0; i < bits; i++)
+    {
+        for (std::size_t j = (MAX_ERRORS > 1 ? i : bits); j <= bits; j++)
+        {
+            auto frame = message;
+            frame[i / 8] ^= static_cast<uint8_t>(1u << (i % 8));
+            if (j != i && j < bits)
+            {
+                frame[j / 8] ^= static_cast<uint8_t>(1u << (j % 8));
+            }
+
+            status &= is_expected(correct<TCrc, MAX_LEN, MAX_ERRORS>(frame.data(), frame.size(), expected), correction::corrected);
+            status &= frame == message;
+        }
+    }
+
+    // errors in the received crc leave the data alone
+    auto frame = message;
+    status &= is_expected(correct<TCrc, MAX_LEN, MAX_ERRORS>(frame.data(), frame.size(), static_cast<typename TCrc::accumulator_type>(expected ^ 0x1u)),
+                          correction::corrected);
+    status &= frame == message;
+
+    status &= is_expected(correct<TCrc, MAX_LEN, MAX_ERRORS>(frame.data(), frame.size(), expected), correction::no_error);
+
+    return status;
+}
+
+TEST_CASE("ErrorCorrection", "TestCorrect")
+{
+    const std::vector<uint8_t> message{ '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+    REQUIRE(test_correct<crc16_x25, 64, 1>(message, 0x906E));
+    REQUIRE(test_correct<crc16_m17lsf, 28, 1>(message, 0x772B));
+    REQUIRE(test_correct<crc32, 64, 1>(message, 0xCBF43926));
+    REQUIRE(test_correct<crc32, 16, 2>(message, 0xCBF43926));
+
+    // frames longer than the table covers are not corrected
+    std::vector<uint8_t> long_frame(17, 0x00);
+    REQUIRE(correct<crc32, 16, 2>(long_frame.data(), long_frame.size(), 0) == correction::uncorrectable);
+}
+
+TEST_CASE("MultiAlgorithm", "TestCRC")
+{
+    const std::vector<uint8_t> message{ '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+    multi<crc32, large::crc32_c, tiny::crc64_ecma, crc8> crc;
+    crc.update(message[0]);
+    crc.update(message.data() + 1, message.size() - 1);
+
+    auto const result = crc.final();
+    REQUIRE(std::get<0>(result) == 0xCBF43926);
+    REQUIRE(std::get<1>(result) == 0xE3069283);
+    REQUIRE(std::get<2>(result) == 0x6C40DF5F0B497347U);
+    REQUIRE(std::get<3>(result) == 0xF4);
+
+    crc.reset();
+    crc.update(message.data(), message.size());
+    REQUIRE(crc.final() == result);
+
+    // blocks are fed to each accumulator's bulk path, not byte by byte
+    using instrumented = impl::crc<alg::crc16_dnp, table_size::small, telemetry::counters>;
+    std::vector<uint8_t> const block(10000, 0x5A);
+    auto const before = telemetry::snapshot<alg::crc16_dnp, table_size::small>();
+
+    multi<instrumented, crc32> blocks;
+    blocks.update(block.data(), block.size());
+
+    auto const after = telemetry::snapshot<alg::crc16_dnp, table_size::small>();
+    REQUIRE(after.bytes - before.bytes == block.size());
+    REQUIRE(after.engine_calls[static_cast<std::size_t>(instrument::engine::per_byte)]
+            == before.engine_calls[static_cast<std::size_t>(instrument::engine::per_byte)]);
+    REQUIRE(after.calls - before.calls < 10);
+
+    crc16_dnp expected;
+    expected.update(block.data(), block.size());
+    REQUIRE(std::get<0>(blocks.final()) == expected.final());
+}
+
+//
+// Compare every lane of a batch against the scalar implementation
+//
+template<typename TCrc, std::size_t LANES> bool test_batch()
+{
+    constexpr std::size_t length = 37;
+
+    std::array<std::vector<uint8_t>, LANES> messages;
+    std::array<uint8_t const*, LANES> pointers{};
+    std::vector<uint8_t> interleaved(length * LANES);
+
+    for (std::size_t lane = 0; lane < LANES; lane++)
+    {
+        for (std::size_t i = 0; i < length; i++)
+        {
+            auto const value = static_cast<uint8_t>(lane * 31 + i * 7 + (i >> 2));
+            messages[lane].push_back(value);
+            interleaved[i * LANES + lane] = value;
+        }
+        pointers[lane] = messages[lane].data();
+    }
+
+    batch<typename TCrc::algorithm, LANES> by_lane;
+    by_lane.update(pointers, length);
+
+    batch<typename TCrc::algorithm, LANES> by_step;
+    by_step.update_interleaved(interleaved.data(), 5);
+    by_step.update_interleaved(interleaved.data() + 5 * LANES, length - 5);
+
+    bool status = true;
+    for (std::size_t lane = 0; lane < LANES; lane++)
+    {
+        TCrc crc;
+        crc.update(messages[lane].data(), length);
+        status &= is_expected(by_lane.final(lane), crc.final());
+        status &= is_expected(by_step.final()[lane], crc.final());
+    }
+
+    return status;
+}
+
+TEST_CASE("Batch", "TestCRC")
+{
+    REQUIRE(test_batch<crc8, 16>());
+    REQUIRE(test_batch<crc8_darc, 32>());
+    REQUIRE(test_batch<crc16_ccit, 16>());
+    REQUIRE(test_batch<crc16_x25, 32>());
+    REQUIRE(test_batch<crc32, 16>());
+    REQUIRE(test_batch<crc64_ecma, 32>());
+
+    const std::vector<uint8_t> message{ '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    std::array<uint8_t const*, 16> pointers{};
+    pointers.fill(message.data());
+
+    batch<alg::crc8> crc;
+    crc.update(pointers, message.size());
+    REQUIRE(crc.final(15) == 0xF4);
+}
+
+template<typename TCrc> bool test_combine(std::vector<uint8_t> const& message)
+{
+    bool status = true;
+
+    TCrc whole;
+    whole.update(message.data(), message.size());
+    auto const expected = whole.final();
+
+    for (std::size_t split = 0; split <= message.size(); split++)
+    {
+        TCrc a;
+        a.update(message.data(), split);
+        TCrc b;
+        b.update(message.data() + split, message.size() - split);
+
+        status &= is_expected(combine<TCrc>(a.final(), b.final(), message.size() - split), expected);
+    }
+
+    return status;
+}
+
+TEST_CASE("Combine", "TestCRC")
+{
+    std::vector<uint8_t> message(300);
+    for (std::size_t i = 0; i < message.size(); i++)
+    {
+        message[i] = static_cast<uint8_t>(i * 13 + 5);
+    }
+
+    REQUIRE(test_combine<crc8>(message));
+    REQUIRE(test_combine<crc8_rohc>(message));
+    REQUIRE(test_combine<crc16_ccit>(message));
+    REQUIRE(test_combine<crc16_x25>(message));
+    REQUIRE(test_combine<crc16_dectr>(message));
+    REQUIRE(test_combine<crc32>(message));
+    REQUIRE(test_combine<crc32_posix>(message));
+    REQUIRE(test_combine<crc64_ecma>(message));
+}
+
+TEST_CASE("Manifest", "TestManifest")
+{
+    std::vector<uint8_t> data(10000);
+    for (std::size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+    }
+
+    crc32 whole;
+    whole.update(data.data(), data.size());
+
+    auto m = manifest<crc32>::build(data.data(), data.size(), 1024, 4);
+    REQUIRE(m.block_count() == 10);
+    REQUIRE(m.file_crc() == whole.final());
+    REQUIRE(m.verify(data.data(), data.size(), 3) == manifest<crc32>::npos);
+
+    // the first of several damaged blocks is reported
+    auto damaged = data;
+    damaged[2500] ^= 0x01;
+    damaged[7000] ^= 0x01;
+    REQUIRE(m.verify(damaged.data(), damaged.size(), 4) == 2);
+    REQUIRE(m.verify_range(damaged.data(), damaged.size(), 6000, 2000) == 6);
+
+    // only the rewritten blocks are recomputed
+    m.update(damaged.data(), damaged.size(), 2500, 1);
+    REQUIRE(m.verify(damaged.data(), damaged.size()) == 6);
+    m.update(damaged.data(), damaged.size(), 7000, 1);
+    REQUIRE(m.verify(damaged.data(), damaged.size()) == manifest<crc32>::npos);
+
+    // length changes
+    damaged.resize(5000);
+    REQUIRE(m.verify(damaged.data(), damaged.size()) == 4);
+    m.update(damaged.data(), damaged.size(), 5000, 0);
+    crc32 truncated;
+    truncated.update(damaged.data(), damaged.size());
+    REQUIRE(m.block_count() == 5);
+    REQUIRE(m.file_crc() == truncated.final());
+
+    // a length change alone only recomputes the blocks from the old or new end, one bulk update each
+    using counted = impl::crc<alg::crc32_d, table_size::small, telemetry::counters>;
+    auto const calls = []() { return telemetry::snapshot<alg::crc32_d, table_size::small>().calls; };
+
+    std::vector<uint8_t> blocks(100 * 1024, 0xA5);
+    auto c = manifest<counted>::build(blocks.data(), blocks.size(), 1024);
+
+    blocks.resize(98 * 1024 + 512);
+    auto before = calls();
+    c.update(blocks.data(), blocks.size(), blocks.size(), 0);
+    REQUIRE(calls() - before == 1);
+
+    blocks.resize(100 * 1024, 0x5A);
+    before = calls();
+    c.update(blocks.data(), blocks.size(), blocks.size(), 0);
+    REQUIRE(calls() - before == 2);
+
+    counted resized;
+    resized.update(blocks.data(), blocks.size());
+    REQUIRE(c.file_crc() == resized.final());
+
+    // sidecar round trip
+    auto const bytes = m.serialize();
+    auto const decoded = manifest<crc32>::deserialize(bytes.data(), bytes.size());
+    REQUIRE(decoded.has_value());
+    REQUIRE(decoded->file_crc() == truncated.final());
+    REQUIRE(decoded->verify(damaged.data(), damaged.size()) == manifest<crc32>::npos);
+    REQUIRE_FALSE(manifest<crc32_c>::deserialize(bytes.data(), bytes.size()).has_value());
+    REQUIRE_FALSE(manifest<crc32>::deserialize(bytes.data(), bytes.size() - 1).has_value());
+
+    // a huge total length must be rejected before anything is allocated for it
+    auto oversized = bytes;
+    std::fill(oversized.begin() + 40, oversized.begin() + 48, uint8_t{0xFF});
+    oversized[47] = 0x0F;
+    REQUIRE_FALSE(manifest<crc32>::deserialize(oversized.data(), oversized.size()).has_value());
+
+    // files
+    auto const path = (std::filesystem::temp_directory_path() / "crc_cpp_manifest_test.bin").string();
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<char const*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+    auto const from_file = manifest<crc64_ecma>::build_file(path, 999, 2);
+    REQUIRE(from_file.has_value());
+    REQUIRE(from_file->verify(data.data(), data.size()) == manifest<crc64_ecma>::npos);
+    REQUIRE(from_file->verify_file(path, 3) == manifest<crc64_ecma>::npos);
+    REQUIRE(from_file->verify_file_range(path, 0, 1) == manifest<crc64_ecma>::npos);
+    std::remove(path.c_str());
+    REQUIRE(from_file->verify_file(path) == 0);
+    REQUIRE_FALSE(manifest<crc64_ecma>::build_file(path, 999).has_value());
+}
+
+TEST_CASE("Assembler", "TestAssembler")
+{
+    std::vector<uint8_t> data(4096);
+    for (std::size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<uint8_t>(i * 11 + 3);
+    }
+
+    crc16_x25 whole;
+    whole.update(data.data(), data.size());
+
+    // chunks of 100 bytes added in a scrambled order from several threads
+    std::size_t const chunk = 100;
+    std::size_t const chunks = (data.size() + chunk - 1) / chunk;
+
+    assembler<crc16_x25> a(data.size());
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < 4; t++)
+    {
+        workers.emplace_back([&, t]() {
+            for (std::size_t n = t; n < chunks; n += 4)
+            {
+                auto const index = (n * 17) % chunks;
+                auto const offset = index * chunk;
+                a.add(offset, data.data() + offset, std::min(chunk, data.size() - offset));
+            }
+        });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+
+    REQUIRE(a.complete());
+    REQUIRE(a.ranges() == 1);
+    REQUIRE(a.final() == whole.final());
+
+    // gaps, overlaps and out of range chunks
+    assembler<crc32> b(10);
+    const std::vector<uint8_t> message{ '1', '2', '3', '4', '5', '6', '7', '8', '9', '0' };
+    REQUIRE(b.add(6, message.data() + 6, 4));
+    REQUIRE(b.add(0, message.data(), 2));
+    REQUIRE_FALSE(b.add(1, message.data() + 1, 2));
+    REQUIRE_FALSE(b.add(5, message.data() + 5, 2));
+    REQUIRE_FALSE(b.add(9, message.data() + 9, 2));
+    REQUIRE(b.ranges() == 2);
+    REQUIRE_FALSE(b.final().has_value());
+    REQUIRE(b.add(2, message.data() + 2, 4));
+    REQUIRE(b.ranges() == 1);
+
+    crc32 expected;
+    expected.update(message.data(), message.size());
+    REQUIRE(b.final() == expected.final());
+}
+
+template<typename TCrc> bool test_update_zeros()
+{
+    bool status = true;
+
+    for (std::size_t const length : {0u, 1u, 7u, 64u, 1000u, 4099u})
+    {
+        TCrc expected;
+        expected.update('x');
+        for (std::size_t i = 0; i < length; i++)
+        {
+            expected.update(0);
+        }
+
+        TCrc crc;
+        crc.update('x');
+        crc.update_zeros(length);
+
+        status &= is_expected(crc.final(), expected.final());
+    }
+
+    return status;
+}
+
+constexpr bool constexpr_check_zeros()
+{
+    crc_cpp::crc16_xmodem zeros;
+    zeros.update_zeros(3);
+
+    crc_cpp::crc16_xmodem bytes;
+    bytes.update(0);
+    bytes.update(0);
+    bytes.update(0);
+
+    return zeros.final() == bytes.final();
+}
+
+static_assert(constexpr_check_zeros(), "Failed to compute zero run at compile time");
+
+TEST_CASE("UpdateZeros", "TestCRC")
+{
+    REQUIRE(test_update_zeros<crc8>());
+    REQUIRE(test_update_zeros<crc8_maxim>());
+    REQUIRE(test_update_zeros<large::crc16_ccit>());
+    REQUIRE(test_update_zeros<crc16_modbus>());
+    REQUIRE(test_update_zeros<tiny::crc32>());
+    REQUIRE(test_update_zeros<crc32_bzip2>());
+    REQUIRE(test_update_zeros<crc64_ecma>());
+}
+
+TEST_CASE("SparseFile", "TestCRC")
+{
+    const std::vector<uint8_t> message{ '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    std::size_t const gap = 8 * 1024 * 1024;
+
+    auto const path = (std::filesystem::temp_directory_path() / "crc_cpp_sparse_test.bin").string();
+    {
+        // seeking past the end leaves a hole on file systems that support them
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<char const*>(message.data()), static_cast<std::streamsize>(message.size()));
+        file.seekp(static_cast<std::streamoff>(message.size() + gap));
+        file.write(reinterpret_cast<char const*>(message.data()), static_cast<std::streamsize>(message.size()));
+    }
+
+    crc32_c expected;
+    expected.update(message.data(), message.size());
+    expected.update_zeros(gap);
+    expected.update(message.data(), message.size());
+
+    REQUIRE(file_crc<crc32_c>(path) == expected.final());
+
+    std::remove(path.c_str());
+    REQUIRE_FALSE(file_crc<crc32_c>(path).has_value());
+}
+
+template<typename TCrc, std::size_t N> bool test_compute_fixed()
+{
+    std::array<uint8_t, N> header{};
+    std::byte raw[N]{};
+    for (std::size_t i = 0; i < N; i++)
+    {
+        header[i] = static_cast<uint8_t>(i * 37u + 11u);
+        raw[i] = std::byte{header[i]};
+    }
+
+    TCrc expected;
+    expected.update(header.data(), header.size());
+
+    return is_expected(compute_fixed<TCrc>(header), expected.final())
+        && is_expected(compute_fixed<TCrc>(raw), expected.final());
+}
+
+template<template<const table_size> class TCrc, std::size_t N> bool test_compute_fixed_sizes()
+{
+    return test_compute_fixed<TCrc<table_size::tiny>, N>()
+        && test_compute_fixed<TCrc<table_size::small>, N>()
+        && test_compute_fixed<TCrc<table_size::large>, N>();
+}
+
+static_assert(compute_fixed<crc_cpp::crc8>(std::array<uint8_t, 9>{ '1', '2', '3', '4', '5', '6', '7', '8', '9' }) == 0xF4,
+              "Failed to compute fixed length crc at compile time");
+
+TEST_CASE("ComputeFixed", "TestCRC")
+{
+    REQUIRE(test_compute_fixed_sizes<family::crc8, 8>());
+    REQUIRE(test_compute_fixed_sizes<family::crc8_maxim, 12>());
+    REQUIRE(test_compute_fixed_sizes<family::crc16_ccit, 8>());
+    REQUIRE(test_compute_fixed_sizes<family::crc16_ccit, 12>());
+    REQUIRE(test_compute_fixed_sizes<family::crc16_ccit, 16>());
+    REQUIRE(test_compute_fixed_sizes<family::crc16_x25, 20>());
+    REQUIRE(test_compute_fixed_sizes<family::crc32, 1>());
+    REQUIRE(test_compute_fixed_sizes<family::crc64_ecma, 20>());
+
+    // beyond FIXED_TABLE_LIMIT the CRC's own table is used
+    REQUIRE(test_compute_fixed_sizes<family::crc32_c, 40>());
+}
+
+template<typename TCrc> bool test_compute_constant()
+{
+    bool status = true;
+
+    std::vector<uint8_t> data(1000);
+    for (std::size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<uint8_t>(i * 131u + 7u);
+    }
+
+    // lengths around the 16 byte slice
+    for (std::size_t const length : {0u, 1u, 15u, 16u, 17u, 64u, 1000u})
+    {
+        TCrc expected;
+        expected.update(data.data(), length);
+
+        status &= is_expected(compute_constant<TCrc>(data.data(), length), expected.final());
+    }
+
+    return status;
+}
+
+template<typename TCrc> bool test_embedded(typename TCrc::accumulator_type constant)
+{
+    TCrc crc;
+    crc.update(resources::license, sizeof(resources::license));
+
+    return is_expected(constant, crc.final())
+        && verify_async<TCrc>(resources::license, constant).get()
+        && verify_async<TCrc>(resources::license, constant, std::launch::deferred).get()
+        && !verify_async<TCrc>(resources::license, static_cast<typename TCrc::accumulator_type>(constant ^ 1u)).get();
+}
+
+constexpr uint8_t check_constant[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+static_assert(compute_constant<crc_cpp::crc32>(check_constant) == 0xCBF43926, "Failed to compute bulk crc at compile time");
+static_assert(compute_constant<crc_cpp::crc16_ccit>(check_constant) == 0x29B1, "Failed to compute bulk crc at compile time");
+
+TEST_CASE("ComputeConstant", "TestCRC")
+{
+    REQUIRE(test_compute_constant<crc8>());
+    REQUIRE(test_compute_constant<crc8_maxim>());
+    REQUIRE(test_compute_constant<crc16_ccit>());
+    REQUIRE(test_compute_constant<crc16_x25>());
+    REQUIRE(test_compute_constant<crc32>());
+    REQUIRE(test_compute_constant<crc32_bzip2>());
+    REQUIRE(test_compute_constant<crc64_ecma>());
+    REQUIRE(test_compute_constant<tiny::crc32_c>());
+}
+
+TEST_CASE("EmbeddedResource", "TestCRC")
+{
+    REQUIRE(test_embedded<crc8>(resources::license_crc8));
+    REQUIRE(test_embedded<crc16_ccit>(resources::license_crc16_ccit));
+    REQUIRE(test_embedded<crc32>(resources::license_crc32));
+    REQUIRE(test_embedded<crc32_c>(resources::license_crc32_c));
+    REQUIRE(test_embedded<crc64_ecma>(resources::license_crc64_ecma));
+}